@@ -0,0 +1,464 @@
+// Instrumentation.h : Hot-path timing shared by all modules.
+//
+//   HOT_PATH_TIMER(name)         times the rest of the enclosing scope; name is evaluated once per
+//                                call site (per template instantiation), so it may be built at run time
+//   HOT_PATH_DUMP_EVERY(ms)      writes a latency table to std::cerr every ms milliseconds and once
+//                                more when the enclosing scope ends; put it at the top of main
+//
+// Each thread records into its own histograms, so recording takes no lock and touches no shared
+// cache line. Histograms use HDR-style buckets: exact below 16 ns, then 16 buckets per power of
+// two (at most 6.25% error), which keeps tail percentiles meaningful without storing samples.
+//
+// Nothing is compiled unless HOT_PATH_TIMING is defined (-DHOT_PATH_TIMING or the project's
+// preprocessor definitions); without it both macros expand to nothing and their arguments are
+// never evaluated.
+//
+
+#pragma once
+
+#ifdef HOT_PATH_TIMING
+
+#include <algorithm>            // std::fill, std::min, std::max
+#include <atomic>               // std::atomic
+#include <chrono>               // std::chrono::steady_clock
+#include <cmath>                // std::ceil
+#include <condition_variable>   // std::condition_variable
+#include <cstdint>              // std::uint64_t
+#include <iomanip>              // std::setw
+#include <iostream>             // std::cerr
+#include <mutex>                // std::mutex, std::lock_guard
+#include <new>                  // std::nothrow
+#include <sstream>              // std::ostringstream
+#include <string>               // std::string
+#include <thread>               // std::thread, std::this_thread
+#include <vector>               // std::vector
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HOT_PATH_RDTSC 1
+#ifdef _MSC_VER
+#include <intrin.h>             // __rdtsc, _BitScanReverse64
+#else
+#include <x86intrin.h>          // __rdtsc
+#endif
+#elif !defined(_WIN32)
+#include <time.h>               // clock_gettime
+#endif
+
+// call sites beyond this many are not recorded
+const std::size_t max_timer_sites = 128;
+
+// bucket layout: values below 16 ns get their own bucket, then 16 sub-buckets per power of two
+// up to 2^40 ns (about 18 minutes); anything longer lands in the last bucket
+const unsigned histogram_sub_bits = 4;
+const std::size_t histogram_sub_buckets = std::size_t(1) << histogram_sub_bits;
+const unsigned histogram_max_bit = 40;
+const std::size_t histogram_buckets = (histogram_max_bit - histogram_sub_bits + 2) * histogram_sub_buckets;
+
+/// <summary>
+/// Raw timestamp: the TSC on x86, CLOCK_MONOTONIC nanoseconds elsewhere.
+/// </summary>
+inline std::uint64_t timing_ticks()
+{
+#if defined(HOT_PATH_RDTSC)
+    return __rdtsc();
+#elif defined(_WIN32)
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1000000000u + static_cast<std::uint64_t>(now.tv_nsec);
+#endif
+}
+
+/// <summary>
+/// Nanoseconds per tick. The TSC rate is measured once against steady_clock (about 10 ms on
+/// first use); this assumes an invariant TSC, which every x86 CPU of the last decade has.
+/// </summary>
+inline double timing_ns_per_tick()
+{
+#if defined(HOT_PATH_RDTSC)
+    static const double ns_per_tick = []()
+    {
+        const auto wall_start = std::chrono::steady_clock::now();
+        const std::uint64_t tick_start = timing_ticks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const std::uint64_t ticks = timing_ticks() - tick_start;
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_start).count();
+        return ticks > 0 ? ns / static_cast<double>(ticks) : 1.0;
+    }();
+    return ns_per_tick;
+#else
+    return 1.0;
+#endif
+}
+
+// index of the highest set bit, value must not be 0
+inline unsigned highest_bit(std::uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index = 0;
+    _BitScanReverse64(&index, value);
+    return static_cast<unsigned>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned index = 0;
+    while (value >>= 1)
+    {
+        ++index;
+    }
+    return index;
+#endif
+}
+
+/// <summary>
+/// Latency histogram written by exactly one thread and read by the dumper. A single writer
+/// means each update is a relaxed load and store, no locked instruction, while the dumper
+/// still reads well defined values.
+/// </summary>
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+    {
+        for (auto& count : counts)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static std::size_t bucket_of(std::uint64_t ns)
+    {
+        if (ns < histogram_sub_buckets)
+        {
+            return static_cast<std::size_t>(ns);
+        }
+        const unsigned bit = highest_bit(ns);
+        if (bit > histogram_max_bit)
+        {
+            return histogram_buckets - 1;
+        }
+        const unsigned magnitude = bit - histogram_sub_bits + 1;
+        const std::size_t sub = static_cast<std::size_t>(ns >> (bit - histogram_sub_bits)) & (histogram_sub_buckets - 1);
+        return magnitude * histogram_sub_buckets + sub;
+    }
+
+    // largest value that falls into bucket
+    static std::uint64_t bucket_top(std::size_t bucket)
+    {
+        if (bucket < histogram_sub_buckets)
+        {
+            return bucket;
+        }
+        const unsigned magnitude = static_cast<unsigned>(bucket / histogram_sub_buckets);
+        const std::uint64_t sub = bucket % histogram_sub_buckets;
+        return ((histogram_sub_buckets + sub + 1) << (magnitude - 1)) - 1;
+    }
+
+    void record(std::uint64_t ns)
+    {
+        bump(counts[bucket_of(ns)], 1);
+        bump(total, ns);
+        if (ns < min.load(std::memory_order_relaxed))
+        {
+            min.store(ns, std::memory_order_relaxed);
+        }
+        if (ns > max.load(std::memory_order_relaxed))
+        {
+            max.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<std::uint64_t> counts[histogram_buckets];
+    std::atomic<std::uint64_t> total{ 0 };
+    std::atomic<std::uint64_t> min{ ~std::uint64_t(0) };
+    std::atomic<std::uint64_t> max{ 0 };
+
+private:
+    static void bump(std::atomic<std::uint64_t>& value, std::uint64_t by)
+    {
+        value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+};
+
+// one thread's histograms, created the first time that thread hits each call site
+struct ThreadTimings
+{
+    ThreadTimings()
+    {
+        for (auto& site : sites)
+        {
+            site.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ThreadTimings()
+    {
+        for (auto& site : sites)
+        {
+            delete site.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<LatencyHistogram*> sites[max_timer_sites];
+
+    // next registered thread, see TimingRegistry::add_thread
+    ThreadTimings* next = nullptr;
+};
+
+/// <summary>
+/// Call site names and every thread's histograms. Only registration takes the lock; threads
+/// that exit leave their histograms behind so their samples still show up in later dumps.
+/// </summary>
+class TimingRegistry
+{
+public:
+    // never destroyed, so threads and the dumper can still use it while statics are torn down
+    static TimingRegistry& instance()
+    {
+        static TimingRegistry* registry = new TimingRegistry;
+        return *registry;
+    }
+
+    std::size_t add_site(const std::string& name)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (names.size() >= max_timer_sites)
+        {
+            return max_timer_sites;
+        }
+        names.push_back(name);
+        return names.size() - 1;
+    }
+
+    // a new thread's histogram table, or nullptr when out of memory (that thread then records
+    // nothing); threads are linked through the table itself so registering allocates nothing else
+    ThreadTimings* add_thread()
+    {
+        ThreadTimings* timings = new (std::nothrow) ThreadTimings;
+        if (timings == nullptr)
+        {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        timings->next = threads;
+        threads = timings;
+        return timings;
+    }
+
+    /// <summary>
+    /// Latency table for every site hit so far, merged over all threads.
+    /// </summary>
+    std::string report()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        std::ostringstream out;
+        out << std::left << std::setw(40) << "site" << std::right;
+        for (const char* column : { "count", "min", "p50", "p90", "p99", "p99.9", "max", "mean" })
+        {
+            out << std::setw(12) << column;
+        }
+        out << "  (ns)\n";
+
+        std::vector<std::uint64_t> merged(histogram_buckets);
+        for (std::size_t site = 0; site < names.size(); ++site)
+        {
+            std::fill(merged.begin(), merged.end(), 0);
+            std::uint64_t count = 0;
+            std::uint64_t total = 0;
+            std::uint64_t min = ~std::uint64_t(0);
+            std::uint64_t max = 0;
+
+            for (const ThreadTimings* thread = threads; thread != nullptr; thread = thread->next)
+            {
+                const LatencyHistogram* histogram = thread->sites[site].load(std::memory_order_acquire);
+                if (histogram == nullptr)
+                {
+                    continue;
+                }
+                for (std::size_t bucket = 0; bucket < histogram_buckets; ++bucket)
+                {
+                    const std::uint64_t n = histogram->counts[bucket].load(std::memory_order_relaxed);
+                    merged[bucket] += n;
+                    count += n;
+                }
+                total += histogram->total.load(std::memory_order_relaxed);
+                min = (std::min)(min, histogram->min.load(std::memory_order_relaxed));
+                max = (std::max)(max, histogram->max.load(std::memory_order_relaxed));
+            }
+
+            if (count == 0)
+            {
+                continue;
+            }
+
+            // percentiles report the top of their bucket, never more than the largest sample
+            auto percentile = [&](double fraction)
+            {
+                const std::uint64_t rank = (std::max)(std::uint64_t(1), static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count))));
+                std::uint64_t seen = 0;
+                for (std::size_t bucket = 0; bucket < histogram_buckets; ++bucket)
+                {
+                    seen += merged[bucket];
+                    if (seen >= rank)
+                    {
+                        return (std::min)(LatencyHistogram::bucket_top(bucket), max);
+                    }
+                }
+                return max;
+            };
+
+            out << std::left << std::setw(40) << names[site] << std::right << std::setw(12) << count << std::setw(12) << min;
+            for (double fraction : { 0.5, 0.9, 0.99, 0.999 })
+            {
+                out << std::setw(12) << percentile(fraction);
+            }
+            out << std::setw(12) << max << std::setw(12) << total / count << "\n";
+        }
+        return out.str();
+    }
+
+private:
+    TimingRegistry() = default;
+
+    std::mutex lock;
+    std::vector<std::string> names;
+    ThreadTimings* threads = nullptr;
+};
+
+// the calling thread's histograms, nullptr when they could not be allocated
+inline ThreadTimings* thread_timings()
+{
+    thread_local ThreadTimings* timings = TimingRegistry::instance().add_thread();
+    return timings;
+}
+
+// a HOT_PATH_TIMER location, registered once
+struct TimerSite
+{
+    explicit TimerSite(const std::string& name) : id(TimingRegistry::instance().add_site(name)) {}
+
+    const std::size_t id;
+};
+
+/// <summary>
+/// Records the time from construction to destruction against a call site. Also records when
+/// the scope is left by an exception. The histogram is found (or allocated) before the clock
+/// starts, so the destructor never allocates and a timed call never pays for it.
+/// </summary>
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const TimerSite& site) : histogram(histogram_for(site.id)), start(timing_ticks()) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer()
+    {
+        const std::uint64_t ticks = timing_ticks() - start;
+        if (histogram != nullptr)
+        {
+            histogram->record(static_cast<std::uint64_t>(static_cast<double>(ticks) * timing_ns_per_tick()));
+        }
+    }
+
+private:
+    // this thread's histogram for a site; nullptr past max_timer_sites or when out of memory,
+    // in which case the sample is skipped rather than failing the timed code
+    static LatencyHistogram* histogram_for(std::size_t id)
+    {
+        ThreadTimings* timings = id < max_timer_sites ? thread_timings() : nullptr;
+        if (timings == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto& slot = timings->sites[id];
+        LatencyHistogram* result = slot.load(std::memory_order_relaxed);
+        if (result == nullptr)
+        {
+            // first sample from this thread at this site; publish it for the dumper
+            result = new (std::nothrow) LatencyHistogram;
+            if (result != nullptr)
+            {
+                slot.store(result, std::memory_order_release);
+            }
+        }
+        return result;
+    }
+
+    LatencyHistogram* const histogram;
+    const std::uint64_t start;
+};
+
+/// <summary>
+/// Background thread writing TimingRegistry::report() every interval, plus a final report
+/// when destroyed. Each report goes out in a single write.
+/// </summary>
+class TimingDumper
+{
+public:
+    TimingDumper(std::chrono::milliseconds interval, std::ostream& out) : out(out)
+    {
+        // measure the tick rate now rather than inside the first timed call
+        timing_ns_per_tick();
+
+        worker = std::thread([this, interval]()
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            while (!wake.wait_for(guard, interval, [this]() { return stopping; }))
+            {
+                write();
+            }
+        });
+    }
+
+    TimingDumper(const TimingDumper&) = delete;
+    TimingDumper& operator=(const TimingDumper&) = delete;
+
+    ~TimingDumper()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        write();
+    }
+
+private:
+    void write()
+    {
+        const std::string text = "[hot path timings]\n" + TimingRegistry::instance().report();
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        out.flush();
+    }
+
+    std::ostream& out;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#define HOT_PATH_CONCAT_INNER(a, b) a##b
+#define HOT_PATH_CONCAT(a, b) HOT_PATH_CONCAT_INNER(a, b)
+
+#define HOT_PATH_TIMER(name) \
+    static const TimerSite HOT_PATH_CONCAT(hot_path_site_, __LINE__)(name); \
+    const ScopedTimer HOT_PATH_CONCAT(hot_path_timer_, __LINE__)(HOT_PATH_CONCAT(hot_path_site_, __LINE__))
+
+#define HOT_PATH_DUMP_EVERY(ms) \
+    const TimingDumper HOT_PATH_CONCAT(hot_path_dumper_, __LINE__)(std::chrono::milliseconds(ms), std::cerr)
+
+#else
+
+#define HOT_PATH_TIMER(name) ((void)0)
+#define HOT_PATH_DUMP_EVERY(ms) ((void)0)
+
+#endif
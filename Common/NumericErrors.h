@@ -0,0 +1,100 @@
+// NumericErrors.h : Error reporting for the checked arithmetic (add_numbers, subtract_numbers, divide)
+//                   that works with and without C++ exceptions.
+//
+// With exceptions (the default), report_numeric_error throws the same std exceptions as before.
+// Built with -fno-exceptions (or MSVC without /EHsc), or with NUMERIC_NO_EXCEPTIONS defined, it
+// instead keeps the error for the calling thread, calls the installed handler (which may log or
+// abort) and the checked function returns the last valid value. Whatever the handler does, the
+// error can be collected with take_numeric_error() right after the call:
+//
+//     const int sum = add_numbers<int>(start, increment, steps);
+//     if (take_numeric_error() != NumericError::None) { ... }
+//
+
+#pragma once
+
+#if !defined(NUMERIC_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define NUMERIC_NO_EXCEPTIONS 1
+#endif
+
+#ifndef NUMERIC_NO_EXCEPTIONS
+#include <stdexcept>    // std::overflow_error, std::underflow_error, std::runtime_error
+#endif
+
+// what a checked operation detected
+enum class NumericError { None, Overflow, Underflow, DivideByZero };
+
+// same text the exceptions carry
+inline const char* numeric_error_message(NumericError error)
+{
+    switch (error)
+    {
+    case NumericError::Overflow:
+        return "OVERFLOW!";
+    case NumericError::Underflow:
+        return "UNDERFLOW!";
+    case NumericError::DivideByZero:
+        return "Dividing by zero!";
+    default:
+        return "";
+    }
+}
+
+// called with every error when exceptions are unavailable, after the error has been stored
+using NumericErrorHandler = void (*)(NumericError error);
+
+// the calling thread's most recent error, set before any handler runs
+inline NumericError& last_numeric_error()
+{
+    thread_local NumericError error = NumericError::None;
+    return error;
+}
+
+// default handler: only keeps the error for take_numeric_error()
+inline void store_numeric_error(NumericError error)
+{
+    last_numeric_error() = error;
+}
+
+// the installed handler; replace it before starting any threads
+inline NumericErrorHandler& numeric_error_handler()
+{
+    static NumericErrorHandler handler = store_numeric_error;
+    return handler;
+}
+
+inline void set_numeric_error_handler(NumericErrorHandler handler)
+{
+    numeric_error_handler() = handler != nullptr ? handler : store_numeric_error;
+}
+
+// the error stored since the last call, clearing it
+inline NumericError take_numeric_error()
+{
+    const NumericError error = last_numeric_error();
+    last_numeric_error() = NumericError::None;
+    return error;
+}
+
+/// <summary>
+/// Throw the matching std exception, or store the error and pass it to the handler when built
+/// without exceptions. Callers return normally afterwards, which only happens in the second case.
+/// </summary>
+inline void report_numeric_error(NumericError error)
+{
+#ifdef NUMERIC_NO_EXCEPTIONS
+    // stored first, so take_numeric_error() still sees it when a replacement handler returns
+    last_numeric_error() = error;
+    numeric_error_handler()(error);
+#else
+    switch (error)
+    {
+    case NumericError::Overflow:
+        throw std::overflow_error(numeric_error_message(error));
+    case NumericError::Underflow:
+        throw std::underflow_error(numeric_error_message(error));
+    default:
+        throw std::runtime_error(numeric_error_message(error));
+    }
+#endif
+}
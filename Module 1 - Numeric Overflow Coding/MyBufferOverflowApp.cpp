@@ -1,8 +1,64 @@
 // NumericOverflows.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
 
+#include <chrono>       // std::chrono::steady_clock
+#include <cstring>      // std::strncpy
+#include <fstream>      // std::ofstream
+#include <iomanip>      // std::setprecision
 #include <iostream>     // std::cout
 #include <limits>       // std::numeric_limits
+#include <sstream>      // std::ostringstream
+#include <stdexcept>    // std::overflow_error, std::underflow_error
+#include <string>       // std::string
+#include <typeinfo>     // typeid
+#include <vector>       // std::vector
+
+#if defined(__GNUG__)
+#include <cstdlib>      // std::free
+#include <cxxabi.h>     // abi::__cxa_demangle
+#endif
+
+// HOT_PATH_TIMER, compiled in only with HOT_PATH_TIMING defined
+#include "../Common/Instrumentation.h"
+// report_numeric_error: throws, or calls a handler in -fno-exceptions builds
+#include "../Common/NumericErrors.h"
+
+/// <summary>
+/// Readable name of T for reports. typeid(T).name() is mangled on GCC / Clang ("y" for
+/// unsigned long long), so the types the tests use are mapped directly and anything else is demangled.
+/// </summary>
+template <typename T> const char* type_name()
+{
+#if defined(__GNUG__)
+    static const std::string name = []()
+    {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status);
+        std::string readable = status == 0 ? demangled : typeid(T).name();
+        std::free(demangled);
+        return readable;
+    }();
+    return name.c_str();
+#else
+    return typeid(T).name();
+#endif
+}
+
+template <> const char* type_name<char>() { return "char"; }
+template <> const char* type_name<wchar_t>() { return "wchar_t"; }
+template <> const char* type_name<short int>() { return "short"; }
+template <> const char* type_name<int>() { return "int"; }
+template <> const char* type_name<long>() { return "long"; }
+template <> const char* type_name<long long>() { return "long long"; }
+template <> const char* type_name<unsigned char>() { return "unsigned char"; }
+template <> const char* type_name<unsigned short int>() { return "unsigned short"; }
+template <> const char* type_name<unsigned int>() { return "unsigned int"; }
+template <> const char* type_name<unsigned long>() { return "unsigned long"; }
+template <> const char* type_name<unsigned long long>() { return "unsigned long long"; }
+template <> const char* type_name<float>() { return "float"; }
+template <> const char* type_name<double>() { return "double"; }
+template <> const char* type_name<long double>() { return "long double"; }
+
 
 /// <summary>
 /// Template function to abstract away the logic of:
@@ -17,6 +73,9 @@
 // use SFINAE to enable function if integrals are used
 template<class T> typename std::enable_if<std::is_integral<T>::value, T>::type add_numbers(T const& start, T const& increment, unsigned long int const& steps)
 {
+    // time every call per type, including the ones that throw
+    HOT_PATH_TIMER(std::string("add_numbers<") + type_name<T>() + ">");
+
     // set result to start value passed
     T result = start;
 
@@ -32,10 +91,11 @@ template<class T> typename std::enable_if<std::is_integral<T>::value, T>::type a
         // get new value each iteration
         left_to_max = max_numeric_limit - result;
 
-        // catch overflow and throw exception if condition met
+        // catch overflow and report it if condition met; without exceptions stop at the last valid value
         if (left_to_max < increment)
         {
-            throw std::overflow_error("OVERFLOW!");
+            report_numeric_error(NumericError::Overflow);
+            return result;
         }
 
         // being here means no overflow. continue.
@@ -50,6 +110,9 @@ template<class T> typename std::enable_if<std::is_integral<T>::value, T>::type a
 // use SFINAE to enable function if floating points are used
 template<class T> typename std::enable_if<std::is_floating_point<T>::value, T>::type add_numbers(T const& start, T const& increment, unsigned long int const& steps)
 {
+    // time every call per type, including the ones that throw
+    HOT_PATH_TIMER(std::string("add_numbers<") + type_name<T>() + ">");
+
     // set result to start value passed
     T result = start;
 
@@ -67,10 +130,11 @@ template<class T> typename std::enable_if<std::is_floating_point<T>::value, T>::
         // get new value each iteration
         left_to_max = max_numeric_limit - result;
 
-        // catch overflow and throw exception if condition met
+        // catch overflow and report it if condition met; without exceptions stop at the last valid value
         if (left_to_max <= increment)
         {
-            throw std::overflow_error("OVERFLOW!");
+            report_numeric_error(NumericError::Overflow);
+            return result;
         }
 
         // being here means no overflow. continue.
@@ -95,6 +159,9 @@ template<class T> typename std::enable_if<std::is_floating_point<T>::value, T>::
 // use SFINAE to enable function if integrals are used
 template<class T> typename std::enable_if<std::is_integral<T>::value, T>::type subtract_numbers(T const& start, T const& decrement, unsigned long int const& steps)
 {
+    // time every call per type, including the ones that throw
+    HOT_PATH_TIMER(std::string("subtract_numbers<") + type_name<T>() + ">");
+
     // set result to start value passed
     T result = start;
 
@@ -110,7 +177,8 @@ template<class T> typename std::enable_if<std::is_integral<T>::value, T>::type s
         // check if underflow happen for this iteration
         if(result < cut_off)
         {
-            throw std::underflow_error("UNDERFLOW!");
+            report_numeric_error(NumericError::Underflow);
+            return result;
         }
 
         // being here means no underflow. continue.
@@ -126,6 +194,9 @@ template<class T> typename std::enable_if<std::is_integral<T>::value, T>::type s
 // use SFINAE to enable function if floating points are used
 template<class T> typename std::enable_if<std::is_floating_point<T>::value, T>::type subtract_numbers(T const& start, T const& decrement, unsigned long int const& steps)
 {
+    // time every call per type, including the ones that throw
+    HOT_PATH_TIMER(std::string("subtract_numbers<") + type_name<T>() + ">");
+
     // set result to start value passed
     T result = start;
 
@@ -141,7 +212,8 @@ template<class T> typename std::enable_if<std::is_floating_point<T>::value, T>::
         // check if underflow happen for this iteration
         if (result < cut_off)
         {
-            throw std::underflow_error("UNDERFLOW!");
+            report_numeric_error(NumericError::Underflow);
+            return result;
         }
 
         // being here means no underflow. continue.
@@ -154,12 +226,274 @@ template<class T> typename std::enable_if<std::is_floating_point<T>::value, T>::
 }
 
 
+// any tested value, kept in its own kind so 64 bit integers and long doubles print exactly
+struct ReportNumber
+{
+    enum class Kind { Signed, Unsigned, Real } kind = Kind::Signed;
+    long long signed_value = 0;
+    unsigned long long unsigned_value = 0;
+    long double real_value = 0;
+};
+
+template <typename T> ReportNumber make_report_number(T value)
+{
+    ReportNumber number;
+    if (std::is_floating_point<T>::value)
+    {
+        number.kind = ReportNumber::Kind::Real;
+        number.real_value = static_cast<long double>(value);
+    }
+    else if (std::is_signed<T>::value)
+    {
+        number.kind = ReportNumber::Kind::Signed;
+        number.signed_value = static_cast<long long>(value);
+    }
+    else
+    {
+        number.kind = ReportNumber::Kind::Unsigned;
+        number.unsigned_value = static_cast<unsigned long long>(value);
+    }
+    return number;
+}
+
+// how a checked call ended
+enum class Outcome { Passed, Overflow, Underflow, Error };
+
+// one checked add_numbers / subtract_numbers call
+struct TestRecord
+{
+    const char* type = "";
+    const char* test = "";          // "overflow" or "underflow"
+    const char* operation = "";     // "add_numbers" or "subtract_numbers"
+    const char* description = "";   // line label for the text report
+    ReportNumber start;
+    ReportNumber step;
+    unsigned long steps = 0;
+    Outcome outcome = Outcome::Passed;
+    ReportNumber result;
+    char message[32] = {};          // error text, copied since the exception does not outlive the catch
+    long long elapsed_ns = 0;
+};
+
+// output formats of TestReport
+enum class ReportFormat { Text, JsonLines, Csv };
+
+/// <summary>
+/// Collects the result of every checked call into a buffer reserved up front and renders them
+/// all at once, so running the tests costs no terminal I/O until the end.
+/// </summary>
+class TestReport
+{
+public:
+    explicit TestReport(std::size_t capacity)
+    {
+        records.reserve(capacity);
+    }
+
+    /// <summary>
+    /// Time call() and record its result, or the overflow / underflow it reported.
+    /// </summary>
+    template <typename T, typename Call>
+    void record(const char* test, const char* operation, const char* description, T start, T step, unsigned long steps, Call call)
+    {
+        TestRecord entry;
+        entry.type = type_name<T>();
+        entry.test = test;
+        entry.operation = operation;
+        entry.description = description;
+        entry.start = make_report_number(start);
+        entry.step = make_report_number(step);
+        entry.steps = steps;
+
+        const auto begin = std::chrono::steady_clock::now();
+#ifdef NUMERIC_NO_EXCEPTIONS
+        // the default handler leaves the error for this thread to pick up
+        take_numeric_error();
+        const T result = call();
+        const NumericError error = take_numeric_error();
+        if (error == NumericError::None)
+        {
+            entry.result = make_report_number(result);
+        }
+        else
+        {
+            entry.outcome = error == NumericError::Overflow ? Outcome::Overflow : error == NumericError::Underflow ? Outcome::Underflow : Outcome::Error;
+            std::strncpy(entry.message, numeric_error_message(error), sizeof(entry.message) - 1);
+        }
+#else
+        try
+        {
+            entry.result = make_report_number(call());
+        }
+        catch (const std::overflow_error& x)
+        {
+            entry.outcome = Outcome::Overflow;
+            std::strncpy(entry.message, x.what(), sizeof(entry.message) - 1);
+        }
+        catch (const std::underflow_error& x)
+        {
+            entry.outcome = Outcome::Underflow;
+            std::strncpy(entry.message, x.what(), sizeof(entry.message) - 1);
+        }
+        catch (const std::exception& x)
+        {
+            entry.outcome = Outcome::Error;
+            std::strncpy(entry.message, x.what(), sizeof(entry.message) - 1);
+        }
+#endif
+        entry.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+        records.push_back(entry);
+    }
+
+    std::size_t size() const
+    {
+        return records.size();
+    }
+
+    /// <summary>
+    /// All records in one string, ready for a single write.
+    /// </summary>
+    /// <param name="star_line">Banner line used between test sections of the text report</param>
+    std::string render(ReportFormat format, const std::string& star_line) const
+    {
+        std::ostringstream out;
+        if (format == ReportFormat::Csv)
+        {
+            out << "type,test,operation,start,step,steps,outcome,result,message,elapsed_ns\n";
+        }
+
+        const char* section = "";
+        const char* type = "";
+        for (const auto& entry : records)
+        {
+            switch (format)
+            {
+            case ReportFormat::Text:
+                // same layout the tests used to print line by line
+                if (std::strcmp(section, entry.test) != 0)
+                {
+                    section = entry.test;
+                    type = "";
+                    out << "\n" << star_line << "\n*** Running " << (entry.test[0] == 'o' ? "Overflow" : "Underflow")
+                        << " Tests ***\n" << star_line << "\n";
+                }
+                if (std::strcmp(type, entry.type) != 0)
+                {
+                    type = entry.type;
+                    out << (entry.test[0] == 'o' ? "Overflow" : "Underflow") << " Test of Type = " << entry.type << "\n";
+                }
+                out << "\t" << entry.description << " (";
+                write_number(out, entry.start, false);
+                out << ", ";
+                write_number(out, entry.step, false);
+                out << ", " << entry.steps << ") = ";
+                if (entry.outcome == Outcome::Passed)
+                {
+                    write_number(out, entry.result, false);
+                }
+                else
+                {
+                    out << entry.message;
+                }
+                out << "  [" << entry.elapsed_ns << " ns]\n";
+                break;
+
+            case ReportFormat::JsonLines:
+                out << "{\"type\":\"" << entry.type << "\",\"test\":\"" << entry.test << "\",\"operation\":\"" << entry.operation
+                    << "\",\"start\":";
+                write_number(out, entry.start, true);
+                out << ",\"step\":";
+                write_number(out, entry.step, true);
+                out << ",\"steps\":" << entry.steps << ",\"outcome\":\"" << outcome_name(entry.outcome) << "\",\"result\":";
+                if (entry.outcome == Outcome::Passed)
+                {
+                    write_number(out, entry.result, true);
+                }
+                else
+                {
+                    out << "null";
+                }
+                out << ",\"message\":\"" << entry.message << "\",\"elapsed_ns\":" << entry.elapsed_ns << "}\n";
+                break;
+
+            case ReportFormat::Csv:
+                out << entry.type << ',' << entry.test << ',' << entry.operation << ',';
+                write_number(out, entry.start, true);
+                out << ',';
+                write_number(out, entry.step, true);
+                out << ',' << entry.steps << ',' << outcome_name(entry.outcome) << ',';
+                if (entry.outcome == Outcome::Passed)
+                {
+                    write_number(out, entry.result, true);
+                }
+                out << ',' << entry.message << ',' << entry.elapsed_ns << '\n';
+                break;
+            }
+        }
+        return out.str();
+    }
+
+private:
+    static const char* outcome_name(Outcome outcome)
+    {
+        switch (outcome)
+        {
+        case Outcome::Passed:
+            return "ok";
+        case Outcome::Overflow:
+            return "overflow";
+        case Outcome::Underflow:
+            return "underflow";
+        default:
+            return "error";
+        }
+    }
+
+    // exact prints reals with enough digits to round trip, otherwise the default 6 like std::cout
+    static void write_number(std::ostringstream& out, const ReportNumber& number, bool exact)
+    {
+        switch (number.kind)
+        {
+        case ReportNumber::Kind::Signed:
+            out << number.signed_value;
+            break;
+        case ReportNumber::Kind::Unsigned:
+            out << number.unsigned_value;
+            break;
+        case ReportNumber::Kind::Real:
+            if (exact)
+            {
+                out << std::setprecision(std::numeric_limits<long double>::max_digits10) << number.real_value << std::setprecision(6);
+            }
+            else
+            {
+                out << number.real_value;
+            }
+            break;
+        }
+    }
+
+    std::vector<TestRecord> records;
+};
+
+// stream buffer that drops everything written to it
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override
+    {
+        return c;
+    }
+};
+
+
 //  NOTE:
 //    You will see the unary ('+') operator used in front of the variables in the test_XXX methods.
 //    This forces the output to be a number for cases where cout would assume it is a character. 
 
 template <typename T>
-void test_overflow()
+void test_overflow(TestReport& report)
 {
     // TODO: The add_numbers template function will overflow in the second method call
     //        You need to change the add_numbers method to:
@@ -190,25 +524,16 @@ void test_overflow()
     std::cout << "Overflow Test of Type = " << typeid(T).name() << std::endl;
     // END DO NOT CHANGE
 
-    // try/catch block to catch Overflow
-    try
-    {
-        std::cout << "\tAdding Numbers Without Overflow (" << +start << ", " << +increment << ", " << steps << ") = ";
-        T result = add_numbers<T>(start, increment, steps);
-        std::cout << +result << std::endl;
+    // the report times each call and catches the Overflow, results are written when all tests are done
+    report.record("overflow", "add_numbers", "Adding Numbers Without Overflow", start, increment, steps,
+                  [&]() { return add_numbers<T>(start, increment, steps); });
 
-        std::cout << "\tAdding Numbers With Overflow (" << +start << ", " << +increment << ", " << (steps + 1) << ") = ";
-        result = add_numbers<T>(start, increment, steps + 1);
-        std::cout << +result << std::endl;
-    }
-    catch (std::exception x) 
-    {
-        std::cout << x.what() << std::endl;
-    }
+    report.record("overflow", "add_numbers", "Adding Numbers With Overflow", start, increment, steps + 1,
+                  [&]() { return add_numbers<T>(start, increment, steps + 1); });
 }
 
 template <typename T>
-void test_underflow()
+void test_underflow(TestReport& report)
 {
 
   
@@ -241,99 +566,251 @@ void test_underflow()
     std::cout << "Underflow Test of Type = " << typeid(T).name() << std::endl;
     // END DO NOT CHANGE
 
-    // try/catch block to catch Underflow
-    try
-    {
-        std::cout << "\tSubtracting Numbers Without Underflow (" << +start << ", " << +decrement << ", " << steps << ") = ";
-        T result = subtract_numbers<T>(start, decrement, steps);
-        std::cout << +result << std::endl;
+    // the report times each call and catches the Underflow, results are written when all tests are done
+    report.record("underflow", "subtract_numbers", "Subtracting Numbers Without Underflow", start, decrement, steps,
+                  [&]() { return subtract_numbers<T>(start, decrement, steps); });
 
-        std::cout << "\tSubtracting Numbers With Underflow (" << +start << ", " << +decrement << ", " << (steps + 1) << ") = "; 
-        result = subtract_numbers<T>(start, decrement, (steps * 2) + 1); // change steps to be multiplied by 2 first so that it reflects 10 steps that can be done before underflow occurs
-        std::cout << +result << std::endl;
-    }
-    catch (std::exception x) 
-    {
-        std::cout << x.what() << std::endl;
-    }
+    // change steps to be multiplied by 2 first so that it reflects 10 steps that can be done before underflow occurs
+    report.record("underflow", "subtract_numbers", "Subtracting Numbers With Underflow", start, decrement, (steps * 2) + 1,
+                  [&]() { return subtract_numbers<T>(start, decrement, (steps * 2) + 1); });
 }
 
-void do_overflow_tests(const std::string& star_line)
+void do_overflow_tests(TestReport& report)
 {
-    std::cout << std::endl << star_line << std::endl;
-    std::cout << "*** Running Overflow Tests ***" << std::endl;
-    std::cout << star_line << std::endl;
 
     // Testing C++ primative times see: https://www.geeksforgeeks.org/c-data-types/
     // signed integers
-    test_overflow<char>();
-    test_overflow<wchar_t>();
-    test_overflow<short int>();
-    test_overflow<int>();
-    test_overflow<long>();
-    test_overflow<long long>();
+    test_overflow<char>(report);
+    test_overflow<wchar_t>(report);
+    test_overflow<short int>(report);
+    test_overflow<int>(report);
+    test_overflow<long>(report);
+    test_overflow<long long>(report);
 
     // unsigned integers
-    test_overflow<unsigned char>();
-    test_overflow<unsigned short int>();
-    test_overflow<unsigned int>();
-    test_overflow<unsigned long>();
-    test_overflow<unsigned long long>();
+    test_overflow<unsigned char>(report);
+    test_overflow<unsigned short int>(report);
+    test_overflow<unsigned int>(report);
+    test_overflow<unsigned long>(report);
+    test_overflow<unsigned long long>(report);
 
     // real numbers
-    test_overflow<float>();
-    test_overflow<double>();
-    test_overflow<long double>();
+    test_overflow<float>(report);
+    test_overflow<double>(report);
+    test_overflow<long double>(report);
 }
 
-void do_underflow_tests(const std::string& star_line)
+void do_underflow_tests(TestReport& report)
 {
-    std::cout << std::endl << star_line << std::endl;
-    std::cout << "*** Running Undeflow Tests ***" << std::endl;
-    std::cout << star_line << std::endl;
 
     // Testing C++ primative times see: https://www.geeksforgeeks.org/c-data-types/
     // signed integers
-    test_underflow<char>();
-    test_underflow<wchar_t>();
-    test_underflow<short int>();
-    test_underflow<int>();
-    test_underflow<long>();
-    test_underflow<long long>();
+    test_underflow<char>(report);
+    test_underflow<wchar_t>(report);
+    test_underflow<short int>(report);
+    test_underflow<int>(report);
+    test_underflow<long>(report);
+    test_underflow<long long>(report);
+
+    // unsigned integers
+    test_underflow<unsigned char>(report);
+    test_underflow<unsigned short int>(report);
+    test_underflow<unsigned int>(report);
+    test_underflow<unsigned long>(report);
+    test_underflow<unsigned long long>(report);
+
+    // real numbers
+    test_underflow<float>(report);
+    test_underflow<double>(report);
+    test_underflow<long double>(report);
+}
+
+// one add_numbers call the way the test driver makes it; true when it overflowed
+template <typename T>
+bool checked_add(T start, T increment, unsigned long steps, T& result)
+{
+#ifdef NUMERIC_NO_EXCEPTIONS
+    result = add_numbers<T>(start, increment, steps);
+    return take_numeric_error() != NumericError::None;
+#else
+    try
+    {
+        result = add_numbers<T>(start, increment, steps);
+        return false;
+    }
+    catch (const std::overflow_error&)
+    {
+        return true;
+    }
+#endif
+}
+
+/// <summary>
+/// Per call latency of add_numbers for T, with the same inputs as test_overflow: once succeeding
+/// and once overflowing. Run it from an exception enabled and a -fno-exceptions build to compare.
+/// </summary>
+template <typename T>
+void benchmark_overflow(std::ostringstream& out, unsigned long iterations)
+{
+    const unsigned long steps = 5;
+
+    // rounding makes 5 * (max / 5) overflow for real numbers (see add_numbers), so the passing
+    // case takes one step less there; failures shows that row really never takes the error path
+    const unsigned long passing = std::is_floating_point<T>::value ? steps - 1 : steps;
+
+    // volatile so the calls cannot be folded into constants
+    volatile T increment = std::numeric_limits<T>::max() / steps;
+    volatile T sink{};
+
+    for (unsigned long call_steps : { passing, steps + 1 })
+    {
+        unsigned long failures = 0;
+        const auto begin = std::chrono::steady_clock::now();
+        for (unsigned long i = 0; i < iterations; ++i)
+        {
+            T result{};
+            failures += checked_add<T>(T(0), increment, call_steps, result) ? 1 : 0;
+            sink = result;
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+#ifdef NUMERIC_NO_EXCEPTIONS
+        out << "no-exceptions,";
+#else
+        out << "exceptions,";
+#endif
+        out << type_name<T>() << ',' << (call_steps == passing ? "no_overflow" : "overflow") << ',' << call_steps << ','
+            << ns / iterations << ',' << failures << '\n';
+    }
+    (void)sink;
+}
+
+/// <summary>
+/// benchmark_overflow for every type in do_overflow_tests, as CSV on std::cout.
+/// compare_exception_builds.sh runs this from both builds and adds their code sizes.
+/// </summary>
+void do_overflow_benchmark(unsigned long iterations)
+{
+    std::ostringstream out;
+    out << "build,type,case,steps,ns_per_call,failures\n";
+
+    // signed integers
+    benchmark_overflow<char>(out, iterations);
+    benchmark_overflow<wchar_t>(out, iterations);
+    benchmark_overflow<short int>(out, iterations);
+    benchmark_overflow<int>(out, iterations);
+    benchmark_overflow<long>(out, iterations);
+    benchmark_overflow<long long>(out, iterations);
 
     // unsigned integers
-    test_underflow<unsigned char>();
-    test_underflow<unsigned short int>();
-    test_underflow<unsigned int>();
-    test_underflow<unsigned long>();
-    test_underflow<unsigned long long>();
+    benchmark_overflow<unsigned char>(out, iterations);
+    benchmark_overflow<unsigned short int>(out, iterations);
+    benchmark_overflow<unsigned int>(out, iterations);
+    benchmark_overflow<unsigned long>(out, iterations);
+    benchmark_overflow<unsigned long long>(out, iterations);
 
     // real numbers
-    test_underflow<float>();
-    test_underflow<double>();
-    test_underflow<long double>();
+    benchmark_overflow<float>(out, iterations);
+    benchmark_overflow<double>(out, iterations);
+    benchmark_overflow<long double>(out, iterations);
+
+    const std::string text = out.str();
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cout.flush();
 }
 
+// checked calls each test driver records, per pass over all 14 types
+const std::size_t records_per_pass = 14 * 2 * 2;
+
 /// <summary>
 /// Entry point into the application
 /// </summary>
-/// <returns>0 when complete</returns>
-int main()
+/// <param name="argc">Options: [--format text|json|csv] [--out file] [--repeat n] [--bench iterations]</param>
+/// <returns>0 when complete, 1 on bad arguments</returns>
+int main(int argc, char* argv[])
 {
     //  create a string of "*" to use in the console
     const std::string star_line = std::string(50, '*');
 
-    // change order to reflect order of tests
-    std::cout << "Starting Numeric Overflow / Underflow Tests!" << std::endl;
+    // hot path latency tables on std::cerr when built with HOT_PATH_TIMING
+    HOT_PATH_DUMP_EVERY(1000);
 
-    // run the overflow tests
-    do_overflow_tests(star_line);
+    ReportFormat format = ReportFormat::Text;
+    std::string out_path;
+    unsigned long repeat = 1;
 
-    // run the underflow tests
-    do_underflow_tests(star_line);
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const std::string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--format" && (value == "text" || value == "json" || value == "csv"))
+        {
+            format = value == "json" ? ReportFormat::JsonLines : value == "csv" ? ReportFormat::Csv : ReportFormat::Text;
+        }
+        else if (arg == "--out" && !value.empty())
+        {
+            out_path = value;
+        }
+        else if (arg == "--repeat" && !value.empty())
+        {
+            repeat = std::stoul(value);
+        }
+        else if (arg == "--bench" && !value.empty())
+        {
+            // latency of the checked calls in this build instead of the tests
+            do_overflow_benchmark(std::stoul(value));
+            return 0;
+        }
+        else
+        {
+            std::cerr << "Usage: MyBufferOverflowApp [--format text|json|csv] [--out file] [--repeat n] [--bench iterations]" << std::endl;
+            return 1;
+        }
+        ++i;
+    }
+
+    // room for every record up front so recording never reallocates mid run
+    TestReport report(records_per_pass * repeat);
+
+    // the test drivers still print their type line to std::cout; point it at nothing while they run
+    // so the only output is the report written at the end
+    NullBuffer discard;
+    std::streambuf* const console = std::cout.rdbuf(&discard);
+
+    for (unsigned long pass = 0; pass < repeat; ++pass)
+    {
+        // run the overflow tests
+        do_overflow_tests(report);
+
+        // run the underflow tests
+        do_underflow_tests(report);
+    }
+
+    std::cout.rdbuf(console);
 
     // change order to reflect order of tests
-    std::cout << std::endl << "All Numeric Overflow / Underflow Tests Complete!" << std::endl;
+    std::string output;
+    if (format == ReportFormat::Text)
+    {
+        output = "Starting Numeric Overflow / Underflow Tests!\n";
+    }
+    output += report.render(format, star_line);
+    if (format == ReportFormat::Text)
+    {
+        output += "\nAll Numeric Overflow / Underflow Tests Complete!\n";
+    }
+
+    // everything in one write
+    if (out_path.empty())
+    {
+        std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        std::cout.flush();
+    }
+    else
+    {
+        std::ofstream out(out_path, std::ios::binary);
+        out.write(output.data(), static_cast<std::streamsize>(output.size()));
+    }
 
     return 0;
 }
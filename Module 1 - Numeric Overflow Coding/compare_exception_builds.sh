@@ -0,0 +1,41 @@
+#!/bin/sh
+# compare_exception_builds.sh : Builds MyBufferOverflowApp with and without exceptions and compares
+#                               code size and per call latency of add_numbers for every tested type.
+#
+# Usage: ./compare_exception_builds.sh [iterations]     (needs g++ or CXX, plus binutils size / nm)
+#
+
+set -e
+
+cd "$(dirname "$0")"
+cxx=${CXX:-g++}
+iterations=${1:-1000000}
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+"$cxx" -std=c++14 -O2 -o "$out/exceptions" MyBufferOverflowApp.cpp
+"$cxx" -std=c++14 -O2 -fno-exceptions -o "$out/no-exceptions" MyBufferOverflowApp.cpp
+
+echo "== code size (bytes)"
+for build in exceptions no-exceptions; do
+    # .text is the code, .eh_frame / .gcc_except_table are the unwind tables exceptions need
+    size -A "$out/$build" | awk -v build="$build" '
+        $1 == ".text" || $1 == ".eh_frame" || $1 == ".gcc_except_table" { printf "%-14s %-18s %8d\n", build, $1, $2 }'
+done
+
+echo
+echo "== benchmark_overflow<T> code size (bytes), add_numbers and its error handling inlined"
+for build in exceptions no-exceptions; do
+    nm -C -S -t d "$out/$build" | awk -v build="$build" '
+        /benchmark_overflow</ {
+            type = $0
+            sub(/.*benchmark_overflow</, "", type)
+            sub(/>\(.*/, "", type)
+            printf "%-14s %-20s %8d\n", build, type, $2
+        }'
+done
+
+echo
+echo "== per call latency (ns)"
+"$out/exceptions" --bench "$iterations"
+"$out/no-exceptions" --bench "$iterations" | tail -n +2
@@ -0,0 +1,442 @@
+// CollectionBenchmark.cpp : Micro-benchmarks for the operations CollectionTest verifies, run against
+//                           std::vector<int> and every alternative container registered in main.
+//
+// Usage: CollectionBenchmark [--format csv|json] [--out file] [--max-size n] [--label text]
+//
+// Timings are taken on the containers exactly as registered. Allocation counts come from a separate
+// untimed pass over the same containers on CountingAllocator; the heap columns are only filled in
+// when built with COUNT_HEAP_ALLOCATIONS defined, which replaces the global operator new.
+//
+
+#include <algorithm>    // std::max, std::min
+#include <chrono>       // std::chrono::steady_clock
+#include <cstdint>      // std::uint64_t
+#include <fstream>      // std::ofstream
+#include <functional>   // std::function
+#include <iostream>     // std::cout, std::cerr
+#include <sstream>      // std::ostringstream
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+#ifdef __linux__
+#include <linux/perf_event.h>   // perf_event_attr
+#include <sys/ioctl.h>          // ioctl
+#include <sys/syscall.h>        // SYS_perf_event_open
+#include <unistd.h>             // syscall, read, close
+#endif
+
+#include "../Module 4 - Unit Testing/Collections.h"
+#include "../Module 4 - Unit Testing/AllocationCounter.h"
+
+/// <summary>
+/// Hardware cache miss counter for the calling thread, read through perf_event_open on Linux.
+/// Reports itself unavailable on other platforms or when the kernel refuses access
+/// (for example perf_event_paranoid > 2 or inside a restricted container).
+/// </summary>
+class CacheMissCounter
+{
+public:
+    CacheMissCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    ~CacheMissCounter()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+#endif
+    }
+
+    bool available() const
+    {
+        return fd >= 0;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // misses since start(), 0 when unavailable
+    std::uint64_t stop()
+    {
+        std::uint64_t misses = 0;
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &misses, sizeof(misses)) != static_cast<ssize_t>(sizeof(misses)))
+            {
+                misses = 0;
+            }
+        }
+#endif
+        return misses;
+    }
+
+private:
+    int fd = -1;
+};
+
+// one row of output
+struct Result
+{
+    std::string container;
+    std::string operation;
+    std::size_t size = 0;
+    double ns_per_op = 0;
+    double allocations_per_op = 0;          // made by the container, through CountingAllocator
+    double bytes_per_op = 0;
+    double heap_allocations_per_op = -1;    // every ::operator new, including arena and pool refills;
+    double heap_bytes_per_op = -1;          // negative unless built with COUNT_HEAP_ALLOCATIONS
+    double cache_misses_per_op = -1; // negative when the counter is unavailable
+};
+
+// how long each measurement runs, and how many elements a batch of containers may hold in total
+// cheap operations on small containers are dominated by the untimed setup, so wall time is capped too
+const std::chrono::milliseconds min_measure_time(50);
+const std::chrono::milliseconds max_wall_time(250);
+const std::size_t batch_elements = 10000000;
+const std::size_t max_batch = 256;
+
+/// <summary>
+/// Time one operation over batches of freshly prepared containers of n elements, then count its
+/// allocations over one more, untimed batch of counted&lt;Collection&gt;, so the timed code is never
+/// instrumented. prepare runs untimed, operation runs once per container; both must take either type.
+/// </summary>
+/// <param name="ops_per_call">How many logical operations one call of operation performs</param>
+template <typename Collection, typename Prepare, typename Operation>
+Result measure(const std::string& container, const std::string& name, std::size_t n, std::size_t ops_per_call,
+               CacheMissCounter& misses, Prepare prepare, Operation operation)
+{
+    const std::size_t batch = std::max<std::size_t>(1, std::min(max_batch, batch_elements / std::max<std::size_t>(n, 1)));
+
+    std::chrono::steady_clock::duration elapsed{};
+    std::size_t calls = 0;
+    std::uint64_t cache_misses = 0;
+
+    const auto wall_start = std::chrono::steady_clock::now();
+    while (elapsed < min_measure_time && std::chrono::steady_clock::now() - wall_start < max_wall_time)
+    {
+        std::vector<Collection> items(batch);
+        for (auto& item : items)
+        {
+            prepare(item);
+        }
+
+        misses.start();
+        const auto start = std::chrono::steady_clock::now();
+        for (auto& item : items)
+        {
+            operation(item);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+        cache_misses += misses.stop();
+        calls += batch;
+    }
+
+    // the counting pass
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+    std::size_t heap_allocations = 0;
+    std::size_t heap_bytes = 0;
+    {
+        std::vector<typename counted<Collection>::type> items(batch);
+        for (auto& item : items)
+        {
+            prepare(item);
+        }
+
+        AllocationScope scope;
+        for (auto& item : items)
+        {
+            operation(item);
+        }
+        allocations = scope.allocations();
+        bytes = scope.bytes();
+        heap_allocations = scope.heap_allocations();
+        heap_bytes = scope.heap_bytes();
+    }
+
+    const double per_call = static_cast<double>(std::max<std::size_t>(ops_per_call, 1));
+    const double ops = static_cast<double>(calls) * per_call;
+    const double counted_ops = static_cast<double>(batch) * per_call;
+
+    Result result;
+    result.container = container;
+    result.operation = name;
+    result.size = n;
+    result.ns_per_op = std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+    result.allocations_per_op = allocations / counted_ops;
+    result.bytes_per_op = bytes / counted_ops;
+#ifdef COUNT_HEAP_ALLOCATIONS
+    result.heap_allocations_per_op = heap_allocations / counted_ops;
+    result.heap_bytes_per_op = heap_bytes / counted_ops;
+#else
+    static_cast<void>(heap_allocations);
+    static_cast<void>(heap_bytes);
+#endif
+    result.cache_misses_per_op = misses.available() ? cache_misses / ops : -1;
+    return result;
+}
+
+// same as CollectionTest::add_entries, with a fixed value pattern so rand() is not what gets timed
+template <typename Collection>
+void add_entries(Collection& collection, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        collection.push_back(static_cast<int>(i % 100));
+    }
+}
+
+/// <summary>
+/// Run every operation from test.cpp for one container type at size n.
+/// </summary>
+template <typename Collection>
+void run_operations(const std::string& container, std::size_t n, CacheMissCounter& misses, std::vector<Result>& results)
+{
+    // generic, so the same operations also run on counted<Collection> for the allocation counts
+    auto empty = [](auto&) {};
+    auto filled = [n](auto& c) { add_entries(c, n); };
+
+    // push_back through add_entries, one op per element
+    results.push_back(measure<Collection>(container, "push_back", n, n, misses, empty,
+        [n](auto& c) { add_entries(c, n); }));
+
+    results.push_back(measure<Collection>(container, "resize_up", n, 1, misses, empty,
+        [n](auto& c) { c.resize(n); }));
+
+    results.push_back(measure<Collection>(container, "resize_down", n, 1, misses, filled,
+        [n](auto& c) { c.resize(n / 2); }));
+
+    results.push_back(measure<Collection>(container, "reserve", n, 1, misses, empty,
+        [n](auto& c) { c.reserve(n); }));
+
+    results.push_back(measure<Collection>(container, "clear", n, 1, misses, filled,
+        [](auto& c) { c.clear(); }));
+
+    results.push_back(measure<Collection>(container, "erase_all", n, 1, misses, filled,
+        [](auto& c) { c.erase(c.begin(), c.end()); }));
+
+    // at() over every index, one op per element; the sum keeps the loads from being optimized away
+    volatile int sink = 0;
+    results.push_back(measure<Collection>(container, "at", n, n, misses, filled,
+        [n, &sink](auto& c)
+        {
+            int sum = 0;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                sum += c.at(i);
+            }
+            sink = sink + sum;
+        }));
+
+    results.push_back(measure<Collection>(container, "assign", n, 1, misses, filled,
+        [n](auto& c) { c.assign(n, 20); }));
+}
+
+// a container under test: its name and the code that benchmarks it at one size
+struct RegisteredContainer
+{
+    std::string name;
+    std::function<void(std::size_t, CacheMissCounter&, std::vector<Result>&)> run;
+};
+
+/// <summary>
+/// Add a container type to the benchmark. Any type with the std::vector operations used by
+/// CollectionTest and a counted&lt;&gt; specialization in AllocationCounter.h can be registered.
+/// </summary>
+template <typename Collection>
+void register_container(std::vector<RegisteredContainer>& registry, const std::string& name)
+{
+    registry.push_back({ name, [name](std::size_t n, CacheMissCounter& misses, std::vector<Result>& results)
+        {
+            run_operations<Collection>(name, n, misses, results);
+        } });
+}
+
+// numbers in the output; unavailable counters become an empty CSV field / JSON null
+std::string format_number(double value)
+{
+    if (value < 0)
+    {
+        return std::string();
+    }
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+// a CSV field, quoted when it holds a separator, quote or line break
+std::string csv_field(const std::string& text)
+{
+    if (text.find_first_of(",\"\r\n") == std::string::npos)
+    {
+        return text;
+    }
+    std::string quoted = "\"";
+    for (char c : text)
+    {
+        quoted += c;
+        if (c == '"')
+        {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+void write_csv(std::ostream& out, const std::vector<Result>& results, const std::string& label)
+{
+    // every row carries the label, so rows from different builds can be concatenated and compared
+    const std::string label_field = csv_field(label);
+    out << "label,container,operation,size,ns_per_op,allocations_per_op,bytes_per_op,heap_allocations_per_op,"
+           "heap_bytes_per_op,cache_misses_per_op\n";
+    for (const auto& r : results)
+    {
+        out << label_field << ',' << r.container << ',' << r.operation << ',' << r.size << ',' << format_number(r.ns_per_op) << ','
+            << format_number(r.allocations_per_op) << ',' << format_number(r.bytes_per_op) << ','
+            << format_number(r.heap_allocations_per_op) << ',' << format_number(r.heap_bytes_per_op) << ','
+            << format_number(r.cache_misses_per_op) << '\n';
+    }
+}
+
+void write_json(std::ostream& out, const std::vector<Result>& results, const std::string& label)
+{
+    auto number = [](double value)
+    {
+        const std::string text = format_number(value);
+        return text.empty() ? std::string("null") : text;
+    };
+
+    // labels come from the command line, escape the characters JSON does not allow raw
+    std::string escaped;
+    for (char c : label)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            escaped += c;
+        }
+    }
+
+    out << "{\n  \"label\": \"" << escaped << "\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& r = results[i];
+        out << "    {\"container\": \"" << r.container << "\", \"operation\": \"" << r.operation
+            << "\", \"size\": " << r.size << ", \"ns_per_op\": " << number(r.ns_per_op)
+            << ", \"allocations_per_op\": " << number(r.allocations_per_op)
+            << ", \"bytes_per_op\": " << number(r.bytes_per_op)
+            << ", \"heap_allocations_per_op\": " << number(r.heap_allocations_per_op)
+            << ", \"heap_bytes_per_op\": " << number(r.heap_bytes_per_op)
+            << ", \"cache_misses_per_op\": " << number(r.cache_misses_per_op) << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+/// <summary>
+/// Entry point into the application
+/// </summary>
+/// <returns>0 when complete, 1 on bad arguments</returns>
+int main(int argc, char* argv[])
+{
+    std::string format = "csv";
+    std::string out_path;
+    std::string label;
+    std::size_t max_size = 10000000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc)
+        {
+            format = argv[++i];
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            out_path = argv[++i];
+        }
+        else if (arg == "--max-size" && i + 1 < argc)
+        {
+            max_size = std::stoull(argv[++i]);
+        }
+        else if (arg == "--label" && i + 1 < argc)
+        {
+            label = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: CollectionBenchmark [--format csv|json] [--out file] [--max-size n] [--label text]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (format != "csv" && format != "json")
+    {
+        std::cerr << "Unknown format: " << format << std::endl;
+        return 1;
+    }
+
+    // register std::vector<int> and the alternatives here; each needs a counted<> specialization
+    std::vector<RegisteredContainer> registry;
+    register_container<std::vector<int>>(registry, "StdVector");
+    register_container<SmallVector<int, 8>>(registry, "SmallVector");
+    register_container<ArenaVector<int>>(registry, "ArenaVector");
+    register_container<PoolVector<int>>(registry, "PoolVector");
+
+    CacheMissCounter misses;
+    if (!misses.available())
+    {
+        std::cerr << "perf_event_open unavailable, cache misses will not be reported" << std::endl;
+    }
+
+    std::vector<Result> results;
+    for (std::size_t n = 10; n <= max_size; n *= 10)
+    {
+        for (const auto& container : registry)
+        {
+            std::cerr << "Running " << container.name << " at " << n << " elements" << std::endl;
+            container.run(n, misses, results);
+        }
+    }
+
+    if (out_path.empty())
+    {
+        format == "json" ? write_json(std::cout, results, label) : write_csv(std::cout, results, label);
+    }
+    else
+    {
+        std::ofstream out(out_path);
+        format == "json" ? write_json(out, results, label) : write_csv(out, results, label);
+    }
+
+    return 0;
+}
@@ -3,6 +3,14 @@
 
 #include <iostream>
 
+// HOT_PATH_TIMER, compiled in only with HOT_PATH_TIMING defined
+#include "../Common/Instrumentation.h"
+// report_numeric_error: throws, or calls a handler in -fno-exceptions builds
+#include "../Common/NumericErrors.h"
+
+// the custom exception demos need exceptions; a -fno-exceptions build only keeps the division
+#ifndef NUMERIC_NO_EXCEPTIONS
+
 // implement a custom exception
 struct CustomException : public _exception 
 {
@@ -47,14 +55,18 @@ void do_custom_application_logic()
     std::cout << "Leaving Custom Application Logic." << std::endl;
 
 }
+#endif
 
 float divide(float num, float den)
 {
+    HOT_PATH_TIMER("divide");
+
     // Throw an exception to deal with divide by zero errors using
-    //  a standard C++ defined exception
+    //  a standard C++ defined exception (the error handler when built without exceptions)
     if (den == 0) 
     {
-        throw std::runtime_error("Dividing by zero!");
+        report_numeric_error(NumericError::DivideByZero);
+        return 0.0f;
     }
     else 
     {
@@ -68,6 +80,19 @@ void do_division() noexcept
     float numerator = 10.0f;
     float denominator = 0;
 
+#ifdef NUMERIC_NO_EXCEPTIONS
+    //  without exceptions divide leaves its error for this thread to collect
+    auto result = divide(numerator, denominator);
+    const NumericError error = take_numeric_error();
+    if (error != NumericError::None)
+    {
+        std::cout << "ERROR OCCURRED!\t" << numeric_error_message(error) << " Occurred in do_division function." << std::endl;
+    }
+    else
+    {
+        std::cout << "divide(" << numerator << ", " << denominator << ") = " << result << std::endl;
+    }
+#else
     //  create an exception handler to capture ONLY the exception thrown
     //  by divide.
     try
@@ -79,12 +104,19 @@ void do_division() noexcept
     {
         std::cout << "EXCEPTION OCCURRED!\t" << x.what() << " Occurred in do_division function." << std::endl;
     }
+#endif
 }
 
 int main()
 {
+    // hot path latency tables on std::cerr when built with HOT_PATH_TIMING
+    HOT_PATH_DUMP_EVERY(1000);
+
     std::cout << "Exceptions Tests!" << std::endl;
 
+#ifdef NUMERIC_NO_EXCEPTIONS
+    do_division();
+#else
     //  Create exception handlers that catch multiple exception types and also
     //  catches uncaught exceptions
     try
@@ -106,6 +138,7 @@ int main()
     {
         std::cout << "Exception: UNCAUGHT EXCEPTION!" << std::endl;
     }
+#endif
 
 }
 
@@ -0,0 +1,399 @@
+// TestLauncher.cpp : Runs the Module 4 unit test binary as parallel shards and merges the results.
+//
+// Usage: TestLauncher <test binary> [--jobs n] [--history file] [--output file] [--seed n] [--work-dir dir]
+//
+// Without a duration history the shards are made by gtest itself (GTEST_TOTAL_SHARDS /
+// GTEST_SHARD_INDEX). Once a history exists, tests are spread so every shard gets about the same
+// expected run time, each shard receiving its test list through a gtest flag file and its position
+// through COLLECTION_TEST_SHARD_INDEX / COLLECTION_TEST_TOTAL_SHARDS. Every shard gets the same
+// COLLECTION_TEST_SEED, so the whole run can be replayed.
+//
+
+#include <algorithm>    // std::sort, std::min_element
+#include <chrono>       // std::chrono::system_clock
+#include <cstdlib>      // std::system, std::strtod
+#include <fstream>      // std::ifstream, std::ofstream
+#include <iostream>     // std::cout, std::cerr
+#include <map>          // std::map
+#include <random>       // std::random_device
+#include <sstream>      // std::ostringstream
+#include <string>       // std::string
+#include <thread>       // std::thread
+#include <utility>      // std::pair
+#include <vector>       // std::vector
+
+// run time assumed for a test the history has never seen
+const double unknown_test_seconds = 0.05;
+
+// whole file as a string, empty when it cannot be read
+std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+// quote a path or argument for the shell
+std::string quote(const std::string& text)
+{
+    return "\"" + text + "\"";
+}
+
+// command prefix that sets an environment variable for the command that follows
+std::string with_env(const std::string& name, const std::string& value)
+{
+#ifdef _WIN32
+    return "set \"" + name + "=" + value + "\" && ";
+#else
+    return name + "=" + value + " ";
+#endif
+}
+
+// value of attribute name inside one XML start tag, empty when missing
+std::string attribute(const std::string& tag, const std::string& name)
+{
+    const std::string key = " " + name + "=\"";
+    const auto start = tag.find(key);
+    if (start == std::string::npos)
+    {
+        return std::string();
+    }
+    const auto value = start + key.size();
+    return tag.substr(value, tag.find('"', value) - value);
+}
+
+/// <summary>
+/// Full names (Suite.Test) of every test in the binary, from --gtest_list_tests.
+/// </summary>
+std::vector<std::string> list_tests(const std::string& binary, const std::string& work_dir)
+{
+    const std::string listing = work_dir + "/test_list.txt";
+    std::system((quote(binary) + " --gtest_list_tests > " + quote(listing)).c_str());
+
+    std::vector<std::string> tests;
+    std::istringstream lines(read_file(listing));
+    std::string line;
+    std::string suite;
+    while (std::getline(lines, line))
+    {
+        // drop "  # TypeParam = ..." comments and trailing carriage returns
+        line = line.substr(0, line.find('#'));
+        while (!line.empty() && (line.back() == ' ' || line.back() == '\r'))
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        // suites are flush left and end with '.', their tests are indented below them
+        if (line[0] != ' ')
+        {
+            suite = line.back() == '.' ? line : std::string();
+        }
+        else if (!suite.empty())
+        {
+            tests.push_back(suite + line.substr(line.find_first_not_of(' ')));
+        }
+    }
+    return tests;
+}
+
+/// <summary>
+/// Seconds per test from earlier runs; one "name&lt;TAB&gt;seconds" line per test.
+/// </summary>
+std::map<std::string, double> load_history(const std::string& path)
+{
+    std::map<std::string, double> history;
+    std::istringstream lines(read_file(path));
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        const auto tab = line.find('\t');
+        if (tab != std::string::npos)
+        {
+            history[line.substr(0, tab)] = std::strtod(line.c_str() + tab + 1, nullptr);
+        }
+    }
+    return history;
+}
+
+void save_history(const std::string& path, const std::map<std::string, double>& history)
+{
+    std::ofstream out(path);
+    for (const auto& entry : history)
+    {
+        out << entry.first << '\t' << entry.second << '\n';
+    }
+}
+
+/// <summary>
+/// Spread tests over shards by expected duration: longest first, each onto the currently
+/// lightest shard (LPT scheduling).
+/// </summary>
+std::vector<std::vector<std::string>> plan_shards(const std::vector<std::string>& tests,
+                                                  const std::map<std::string, double>& history,
+                                                  std::size_t shards)
+{
+    std::vector<std::pair<double, std::string>> by_duration;
+    for (const auto& test : tests)
+    {
+        const auto known = history.find(test);
+        by_duration.emplace_back(known != history.end() ? known->second : unknown_test_seconds, test);
+    }
+    std::sort(by_duration.begin(), by_duration.end(),
+              [](const std::pair<double, std::string>& a, const std::pair<double, std::string>& b) { return a.first > b.first; });
+
+    std::vector<std::vector<std::string>> plan(shards);
+    std::vector<double> load(shards, 0.0);
+    for (const auto& entry : by_duration)
+    {
+        const auto lightest = static_cast<std::size_t>(std::min_element(load.begin(), load.end()) - load.begin());
+        plan[lightest].push_back(entry.second);
+        load[lightest] += entry.first;
+    }
+    return plan;
+}
+
+// one <testsuite> merged across shards
+struct SuiteReport
+{
+    long tests = 0;
+    long failures = 0;
+    long disabled = 0;
+    long skipped = 0;
+    long errors = 0;
+    double time = 0;
+    std::string body;
+};
+
+/// <summary>
+/// Merge the shards' gtest XML reports into one, joining suites that were split between
+/// shards, and record each test's duration into history.
+/// </summary>
+/// <returns>false when a shard produced no report</returns>
+bool merge_reports(const std::vector<std::string>& reports, const std::string& output, std::map<std::string, double>& history)
+{
+    bool complete = true;
+    std::vector<std::string> order;
+    std::map<std::string, SuiteReport> suites;
+
+    for (const auto& path : reports)
+    {
+        const std::string xml = read_file(path);
+        if (xml.find("<testsuites") == std::string::npos)
+        {
+            std::cerr << "Missing or unreadable report: " << path << std::endl;
+            complete = false;
+            continue;
+        }
+
+        std::size_t position = 0;
+        while ((position = xml.find("<testsuite ", position)) != std::string::npos)
+        {
+            const auto tag_end = xml.find('>', position);
+            const auto close = xml.find("</testsuite>", tag_end);
+            const std::string tag = xml.substr(position, tag_end - position);
+            const std::string body = xml.substr(tag_end + 1, close - tag_end - 1);
+            position = close;
+
+            const std::string name = attribute(tag, "name");
+            if (suites.find(name) == suites.end())
+            {
+                order.push_back(name);
+            }
+
+            SuiteReport& suite = suites[name];
+            suite.tests += std::atol(attribute(tag, "tests").c_str());
+            suite.failures += std::atol(attribute(tag, "failures").c_str());
+            suite.disabled += std::atol(attribute(tag, "disabled").c_str());
+            suite.skipped += std::atol(attribute(tag, "skipped").c_str());
+            suite.errors += std::atol(attribute(tag, "errors").c_str());
+            suite.time += std::strtod(attribute(tag, "time").c_str(), nullptr);
+            suite.body += body;
+
+            // remember how long each test took for the next run's plan
+            std::size_t test = 0;
+            while ((test = body.find("<testcase ", test)) != std::string::npos)
+            {
+                const std::string test_tag = body.substr(test, body.find('>', test) - test);
+                history[attribute(test_tag, "classname") + "." + attribute(test_tag, "name")] =
+                    std::strtod(attribute(test_tag, "time").c_str(), nullptr);
+                ++test;
+            }
+        }
+    }
+
+    SuiteReport total;
+    for (const auto& entry : suites)
+    {
+        total.tests += entry.second.tests;
+        total.failures += entry.second.failures;
+        total.disabled += entry.second.disabled;
+        total.skipped += entry.second.skipped;
+        total.errors += entry.second.errors;
+        total.time += entry.second.time;
+    }
+
+    std::ofstream out(output);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out << "<testsuites tests=\"" << total.tests << "\" failures=\"" << total.failures << "\" disabled=\"" << total.disabled
+        << "\" skipped=\"" << total.skipped << "\" errors=\"" << total.errors << "\" time=\"" << total.time << "\" name=\"AllTests\">\n";
+    for (const auto& name : order)
+    {
+        const SuiteReport& suite = suites[name];
+        out << "  <testsuite name=\"" << name << "\" tests=\"" << suite.tests << "\" failures=\"" << suite.failures
+            << "\" disabled=\"" << suite.disabled << "\" skipped=\"" << suite.skipped << "\" errors=\"" << suite.errors
+            << "\" time=\"" << suite.time << "\">" << suite.body << "</testsuite>\n";
+    }
+    out << "</testsuites>\n";
+
+    return complete;
+}
+
+/// <summary>
+/// Entry point into the application
+/// </summary>
+/// <returns>0 when every shard passed</returns>
+int main(int argc, char* argv[])
+{
+    const char* const usage = "Usage: TestLauncher <test binary> [--jobs n] [--history file] [--output file] [--seed n] [--work-dir dir]";
+    if (argc < 2)
+    {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    const std::string binary = argv[1];
+    std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string history_path = "test_durations.tsv";
+    std::string output = "test_results.xml";
+    std::string work_dir = ".";
+    std::string seed;
+
+    for (int i = 2; i < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 == argc)
+        {
+            // every option takes a value, a trailing one without it is a mistake, not a default
+            std::cerr << "Missing value for option: " << arg << std::endl << usage << std::endl;
+            return 1;
+        }
+        if (arg == "--jobs")
+        {
+            jobs = std::max<std::size_t>(1, std::stoul(argv[i + 1]));
+        }
+        else if (arg == "--history")
+        {
+            history_path = argv[i + 1];
+        }
+        else if (arg == "--output")
+        {
+            output = argv[i + 1];
+        }
+        else if (arg == "--seed")
+        {
+            seed = argv[i + 1];
+        }
+        else if (arg == "--work-dir")
+        {
+            work_dir = argv[i + 1];
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl << usage << std::endl;
+            return 1;
+        }
+    }
+
+    // one seed for the whole run, logged so it can be passed back with --seed
+    if (seed.empty())
+    {
+        std::random_device device;
+        seed = std::to_string((static_cast<unsigned long long>(device()) << 32) ^ device());
+    }
+    std::cout << "Seed: " << seed << std::endl;
+
+    const std::vector<std::string> tests = list_tests(binary, work_dir);
+    if (tests.empty())
+    {
+        std::cerr << "No tests found in " << binary << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, double> history = load_history(history_path);
+    const std::size_t shards = std::min(jobs, tests.size());
+    const bool balanced = !history.empty();
+
+    // build every shard's command line
+    std::vector<std::string> commands(shards);
+    std::vector<std::string> reports(shards);
+    const auto plan = plan_shards(tests, history, shards);
+    for (std::size_t shard = 0; shard < shards; ++shard)
+    {
+        const std::string index = std::to_string(shard);
+        const std::string total = std::to_string(shards);
+        reports[shard] = work_dir + "/shard_" + index + ".xml";
+
+        std::string command = with_env("COLLECTION_TEST_SEED", seed);
+        std::string arguments = " " + quote("--gtest_output=xml:" + reports[shard]);
+
+        if (balanced)
+        {
+            // explicit test list, too long for some command lines, so pass it through a flag file
+            const std::string flag_file = work_dir + "/shard_" + index + ".flags";
+            std::ofstream flags(flag_file);
+            flags << "--gtest_filter=";
+            for (std::size_t i = 0; i < plan[shard].size(); ++i)
+            {
+                flags << (i > 0 ? ":" : "") << plan[shard][i];
+            }
+            flags << "\n";
+
+            command += with_env("COLLECTION_TEST_SHARD_INDEX", index) + with_env("COLLECTION_TEST_TOTAL_SHARDS", total);
+            arguments += " " + quote("--gtest_flagfile=" + flag_file);
+        }
+        else
+        {
+            command += with_env("GTEST_SHARD_INDEX", index) + with_env("GTEST_TOTAL_SHARDS", total);
+        }
+
+        commands[shard] = command + quote(binary) + arguments + " > " + quote(work_dir + "/shard_" + index + ".log") + " 2>&1";
+    }
+
+    std::cout << "Running " << tests.size() << " tests in " << shards << " shards ("
+              << (balanced ? "balanced by history" : "gtest sharding, no history yet") << ")" << std::endl;
+
+    // run all shards at once and wait for them
+    std::vector<int> results(shards, 0);
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t shard = 0; shard < shards; ++shard)
+    {
+        workers.emplace_back([&, shard]() { results[shard] = std::system(commands[shard].c_str()); });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const bool complete = merge_reports(reports, output, history);
+    save_history(history_path, history);
+
+    int failed = 0;
+    for (std::size_t shard = 0; shard < shards; ++shard)
+    {
+        if (results[shard] != 0)
+        {
+            std::cout << "Shard " << shard << " failed, see " << work_dir << "/shard_" << shard << ".log" << std::endl;
+            ++failed;
+        }
+    }
+
+    std::cout << "Finished in " << seconds << " s, report written to " << output << std::endl;
+    return failed == 0 && complete ? 0 : 1;
+}
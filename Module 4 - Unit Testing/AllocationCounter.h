@@ -0,0 +1,248 @@
+// AllocationCounter.h : Allocation counting for the unit tests.
+//
+// Two sources feed the counters:
+//   CountingAllocator   wraps a container's allocator and counts every request the container makes,
+//                       which is exactly the number of (re)allocations it performed
+//   global new hook     optional replacement of ::operator new / delete that counts every heap
+//                       allocation on the thread; define COUNT_HEAP_ALLOCATIONS before including
+//                       this header in exactly one source file to install it
+//
+// AllocationScope snapshots both sets of counters and reports what happened since, and
+// counted<Collection>::type is Collection with CountingAllocator layered over its allocator.
+//
+
+#pragma once
+
+#include <cstddef>      // std::size_t
+#include <cstdlib>      // std::malloc, std::free
+#include <memory>       // std::allocator, std::allocator_traits
+#include <new>          // std::bad_alloc
+#include <type_traits>  // std::true_type, std::false_type
+#include <vector>       // std::vector
+#include "Collections.h"
+
+// running totals for one thread
+struct AllocationCounts
+{
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    std::size_t bytes = 0;
+};
+
+// requests made through CountingAllocator on this thread
+inline AllocationCounts& container_allocation_counts()
+{
+    thread_local AllocationCounts counts;
+    return counts;
+}
+
+// ::operator new calls on this thread, only updated when the global hook is installed
+inline AllocationCounts& heap_allocation_counts()
+{
+    thread_local AllocationCounts counts;
+    return counts;
+}
+
+/// <summary>
+/// Counts container and heap allocations made on this thread from construction (or the last
+/// reset) onwards. Scopes nest freely since each one only keeps its own starting point.
+/// </summary>
+class AllocationScope
+{
+public:
+    AllocationScope()
+    {
+        reset();
+    }
+
+    // start counting from zero again
+    void reset()
+    {
+        container_start = container_allocation_counts();
+        heap_start = heap_allocation_counts();
+    }
+
+    // allocations requested by containers through CountingAllocator
+    std::size_t allocations() const
+    {
+        return container_allocation_counts().allocations - container_start.allocations;
+    }
+
+    // bytes requested by containers through CountingAllocator
+    std::size_t bytes() const
+    {
+        return container_allocation_counts().bytes - container_start.bytes;
+    }
+
+    std::size_t deallocations() const
+    {
+        return container_allocation_counts().deallocations - container_start.deallocations;
+    }
+
+    // every ::operator new on this thread; always 0 unless the global hook is installed
+    std::size_t heap_allocations() const
+    {
+        return heap_allocation_counts().allocations - heap_start.allocations;
+    }
+
+    std::size_t heap_bytes() const
+    {
+        return heap_allocation_counts().bytes - heap_start.bytes;
+    }
+
+private:
+    AllocationCounts container_start;
+    AllocationCounts heap_start;
+};
+
+/// <summary>
+/// Allocator adaptor that counts each allocate / deallocate and then forwards to Base.
+/// Everything else (max_size, equality, rebinding) behaves exactly like Base, so a container
+/// using it follows the same code paths as one using Base directly.
+/// </summary>
+/// <typeparam name="T">Element type</typeparam>
+/// <typeparam name="Base">The allocator actually providing memory</typeparam>
+template <typename T, typename Base = std::allocator<T>>
+struct CountingAllocator
+{
+    using value_type = T;
+    using base_traits = std::allocator_traits<Base>;
+    using size_type = typename base_traits::size_type;
+    using propagate_on_container_copy_assignment = typename base_traits::propagate_on_container_copy_assignment;
+    using propagate_on_container_move_assignment = typename base_traits::propagate_on_container_move_assignment;
+    using propagate_on_container_swap = typename base_traits::propagate_on_container_swap;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = CountingAllocator<U, typename base_traits::template rebind_alloc<U>>;
+    };
+
+    CountingAllocator() = default;
+
+    explicit CountingAllocator(const Base& base) : base(base) {}
+
+    template <typename U, typename OtherBase>
+    CountingAllocator(const CountingAllocator<U, OtherBase>& other) : base(other.base) {}
+
+    T* allocate(std::size_t n)
+    {
+        T* result = base_traits::allocate(base, n);
+        auto& counts = container_allocation_counts();
+        ++counts.allocations;
+        counts.bytes += n * sizeof(T);
+        return result;
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        ++container_allocation_counts().deallocations;
+        base_traits::deallocate(base, ptr, n);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return base_traits::max_size(base);
+    }
+
+    CountingAllocator select_on_container_copy_construction() const
+    {
+        return CountingAllocator(base_traits::select_on_container_copy_construction(base));
+    }
+
+    Base base;
+};
+
+template <typename T, typename BaseT, typename U, typename BaseU>
+bool operator==(const CountingAllocator<T, BaseT>& a, const CountingAllocator<U, BaseU>& b) noexcept
+{
+    return a.base == b.base;
+}
+
+template <typename T, typename BaseT, typename U, typename BaseU>
+bool operator!=(const CountingAllocator<T, BaseT>& a, const CountingAllocator<U, BaseU>& b) noexcept
+{
+    return !(a == b);
+}
+
+// whether an allocator is a CountingAllocator, i.e. a container using it is counted
+template <typename Allocator>
+struct is_counting_allocator : std::false_type
+{
+};
+
+template <typename T, typename Base>
+struct is_counting_allocator<CountingAllocator<T, Base>> : std::true_type
+{
+};
+
+// the same container with CountingAllocator layered over its allocator, so a test or benchmark can see
+// every (re)allocation the container makes without changing how it behaves
+template <typename Collection>
+struct counted;
+
+template <typename T, typename Allocator>
+struct counted<std::vector<T, Allocator>>
+{
+    using type = std::vector<T, CountingAllocator<T, Allocator>>;
+};
+
+template <typename T, std::size_t N, typename Allocator>
+struct counted<SmallVector<T, N, Allocator>>
+{
+    using type = SmallVector<T, N, CountingAllocator<T, Allocator>>;
+};
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// replacement global allocation functions; the nothrow and array forms of the standard library
+// forward to these, so one set of counters sees every plain heap allocation
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC sees free() inlined next to a new-expression and reports a mismatch; the pair is ours
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t bytes)
+{
+    void* ptr = std::malloc(bytes == 0 ? 1 : bytes);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    auto& counts = heap_allocation_counts();
+    ++counts.allocations;
+    counts.bytes += bytes;
+    return ptr;
+}
+
+void* operator new[](std::size_t bytes)
+{
+    return ::operator new(bytes);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+    {
+        ++heap_allocation_counts().deallocations;
+        std::free(ptr);
+    }
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
@@ -0,0 +1,578 @@
+// Collections.h : Alternative vector-like containers that must behave like std::vector<int>
+//                 for everything CollectionTest checks.
+//
+
+#pragma once
+
+#include <algorithm>    // std::max, std::min
+#include <cstddef>      // std::size_t, std::ptrdiff_t
+#include <limits>       // std::numeric_limits
+#include <memory>       // std::allocator, std::allocator_traits, std::shared_ptr
+#include <mutex>        // std::mutex, std::lock_guard
+#include <new>          // ::operator new
+#include <stdexcept>    // std::length_error, std::out_of_range
+#include <type_traits>  // std::is_nothrow_move_constructible
+#include <utility>      // std::move, std::move_if_noexcept
+#include <vector>       // std::vector
+
+/// <summary>
+/// Vector with room for N elements inside the object itself. Small collections never touch
+/// the heap; once it grows past N it moves to heap storage like std::vector.
+/// </summary>
+/// <typeparam name="T">Element type</typeparam>
+/// <typeparam name="N">Number of elements stored inline</typeparam>
+/// <typeparam name="Allocator">Source of heap storage once the inline buffer is outgrown</typeparam>
+template <typename T, std::size_t N, typename Allocator = std::allocator<T>>
+class SmallVector
+{
+    static_assert(N > 0, "SmallVector needs at least one inline element");
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() : storage(inline_storage()), used(0), room(N) {}
+
+    SmallVector(const SmallVector& other)
+        : alloc(alloc_traits::select_on_container_copy_construction(other.alloc)), storage(inline_storage()), used(0), room(N)
+    {
+        reserve(other.used);
+        for (const auto& value : other)
+        {
+            new (storage + used) T(value);
+            ++used;
+        }
+    }
+
+    // the allocator is copied rather than moved, so other keeps a working allocator and both
+    // compare equal; heap storage can then always be taken over without allocating
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        : alloc(other.alloc), storage(inline_storage()), used(0), room(N)
+    {
+        if (other.on_heap())
+        {
+            adopt(other);
+        }
+        else
+        {
+            // at most N elements, so they fit the inline buffer
+            move_elements(other);
+        }
+    }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if (this != &other)
+        {
+            SmallVector copy(other);
+            clear();
+            release();
+            take(copy);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        clear();
+        release();
+    }
+
+    iterator begin() noexcept { return storage; }
+    iterator end() noexcept { return storage + used; }
+    const_iterator begin() const noexcept { return storage; }
+    const_iterator end() const noexcept { return storage + used; }
+
+    T* data() noexcept { return storage; }
+    const T* data() const noexcept { return storage; }
+
+    bool empty() const noexcept { return used == 0; }
+    size_type size() const noexcept { return used; }
+    size_type capacity() const noexcept { return room; }
+
+    size_type max_size() const noexcept
+    {
+        const size_type addressable = static_cast<size_type>(std::numeric_limits<difference_type>::max()) / sizeof(T);
+        return std::min(addressable, static_cast<size_type>(alloc_traits::max_size(alloc)));
+    }
+
+    allocator_type get_allocator() const { return alloc; }
+
+    T& operator[](size_type index) { return storage[index]; }
+    const T& operator[](size_type index) const { return storage[index]; }
+
+    T& at(size_type index)
+    {
+        check_index(index);
+        return storage[index];
+    }
+
+    const T& at(size_type index) const
+    {
+        check_index(index);
+        return storage[index];
+    }
+
+    T& front() { return storage[0]; }
+    T& back() { return storage[used - 1]; }
+
+    void reserve(size_type count)
+    {
+        check_length(count, "SmallVector::reserve");
+        if (count > room)
+        {
+            grow_to(count);
+        }
+    }
+
+    void push_back(const T& value)
+    {
+        if (used == room)
+        {
+            // value may live in the storage that is about to move
+            T copy(value);
+            grow_to(next_capacity(used + 1));
+            new (storage + used) T(std::move(copy));
+        }
+        else
+        {
+            new (storage + used) T(value);
+        }
+        ++used;
+    }
+
+    void push_back(T&& value)
+    {
+        if (used == room)
+        {
+            T copy(std::move(value));
+            grow_to(next_capacity(used + 1));
+            new (storage + used) T(std::move(copy));
+        }
+        else
+        {
+            new (storage + used) T(std::move(value));
+        }
+        ++used;
+    }
+
+    void pop_back()
+    {
+        storage[--used].~T();
+    }
+
+    void resize(size_type count)
+    {
+        check_length(count, "SmallVector::resize");
+        if (count > room)
+        {
+            // grow like std::vector: at least double the current size
+            grow_to(std::max(count, used * 2));
+        }
+        while (used > count)
+        {
+            pop_back();
+        }
+        for (; used < count; ++used)
+        {
+            new (storage + used) T();
+        }
+    }
+
+    void assign(size_type count, const T& value)
+    {
+        check_length(count, "SmallVector::assign");
+
+        // value may be one of our own elements
+        T copy(value);
+        clear();
+        reserve(count);
+        for (; used < count; ++used)
+        {
+            new (storage + used) T(copy);
+        }
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        iterator target = storage + (first - storage);
+        iterator source = storage + (last - storage);
+        if (target == source)
+        {
+            return target;
+        }
+
+        // slide the tail down over the erased range, then drop the leftovers
+        iterator out = std::move(source, end(), target);
+        const size_type new_size = static_cast<size_type>(out - storage);
+        while (used > new_size)
+        {
+            pop_back();
+        }
+        return target;
+    }
+
+    iterator erase(const_iterator position)
+    {
+        return erase(position, position + 1);
+    }
+
+    void clear() noexcept
+    {
+        while (used > 0)
+        {
+            storage[--used].~T();
+        }
+    }
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    T* inline_storage() noexcept
+    {
+        return reinterpret_cast<T*>(buffer);
+    }
+
+    bool on_heap() const noexcept
+    {
+        return storage != reinterpret_cast<const T*>(buffer);
+    }
+
+    void check_index(size_type index) const
+    {
+        if (index >= used)
+        {
+            throw std::out_of_range("SmallVector::at");
+        }
+    }
+
+    void check_length(size_type count, const char* what) const
+    {
+        if (count > max_size())
+        {
+            throw std::length_error(what);
+        }
+    }
+
+    // geometric growth, same factor as the common std::vector implementations
+    size_type next_capacity(size_type needed) const
+    {
+        check_length(needed, "SmallVector::push_back");
+        const size_type doubled = room > max_size() / 2 ? max_size() : room * 2;
+        return std::max(doubled, needed);
+    }
+
+    void grow_to(size_type count)
+    {
+        T* bigger = alloc_traits::allocate(alloc, count);
+        for (size_type i = 0; i < used; ++i)
+        {
+            new (bigger + i) T(std::move_if_noexcept(storage[i]));
+            storage[i].~T();
+        }
+        release();
+        storage = bigger;
+        room = count;
+    }
+
+    // free heap storage (elements must already be destroyed) and go back to the inline buffer
+    void release() noexcept
+    {
+        if (on_heap())
+        {
+            alloc_traits::deallocate(alloc, storage, room);
+        }
+        storage = inline_storage();
+        room = N;
+    }
+
+    // steal other's elements; this must be empty and inline
+    void take(SmallVector& other)
+    {
+        // heap storage can only change hands between allocators that can free each other's memory
+        if (other.on_heap() && alloc == other.alloc)
+        {
+            adopt(other);
+            return;
+        }
+
+        reserve(other.used);
+        move_elements(other);
+    }
+
+    // take over other's heap storage; this must be empty and inline
+    void adopt(SmallVector& other) noexcept
+    {
+        storage = other.storage;
+        used = other.used;
+        room = other.room;
+        other.storage = other.inline_storage();
+        other.used = 0;
+        other.room = N;
+    }
+
+    // move other's elements one by one; this must be empty with room for them
+    void move_elements(SmallVector& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+        for (size_type i = 0; i < other.used; ++i)
+        {
+            new (storage + i) T(std::move(other.storage[i]));
+        }
+        used = other.used;
+        other.clear();
+    }
+
+    Allocator alloc;
+    alignas(T) unsigned char buffer[N * sizeof(T)];
+    T* storage;
+    size_type used;
+    size_type room;
+};
+
+/// <summary>
+/// Monotonic arena: hands out memory by bumping a pointer through large blocks and only
+/// gives it back when the arena itself is destroyed.
+/// </summary>
+class Arena
+{
+public:
+    explicit Arena(std::size_t block_size = 64 * 1024) : block_size(block_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+        for (auto block : blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+
+    void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        std::size_t pad = (alignment - reinterpret_cast<std::size_t>(cursor) % alignment) % alignment;
+        if (cursor == nullptr || pad + bytes > left)
+        {
+            // oversized requests get a block of their own
+            const std::size_t size = std::max(block_size, bytes + alignment);
+            unsigned char* block = static_cast<unsigned char*>(::operator new(size));
+            blocks.push_back(block);
+            cursor = block;
+            left = size;
+            pad = (alignment - reinterpret_cast<std::size_t>(cursor) % alignment) % alignment;
+        }
+
+        unsigned char* result = cursor + pad;
+        cursor = result + bytes;
+        left -= pad + bytes;
+        return result;
+    }
+
+    // individual frees are ignored, everything is released with the arena
+    void deallocate(void*, std::size_t) noexcept {}
+
+private:
+    std::size_t block_size;
+    std::vector<unsigned char*> blocks;
+    unsigned char* cursor = nullptr;
+    std::size_t left = 0;
+};
+
+/// <summary>
+/// Allocator over a shared Arena. A default constructed allocator creates its own arena,
+/// copies (and rebinds) share it.
+/// </summary>
+template <typename T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator() : arena(std::make_shared<Arena>()) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        arena->deallocate(ptr, n * sizeof(T));
+    }
+
+    std::shared_ptr<Arena> arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+{
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+/// <summary>
+/// Process wide free-list pool. Blocks are rounded up to a power of two size class and kept
+/// on that class's free list when released, so steady state reallocation never reaches the
+/// system allocator. Requests above the largest class go straight to ::operator new.
+/// </summary>
+class BlockPool
+{
+public:
+    static constexpr std::size_t min_block = 16;
+    static constexpr std::size_t class_count = 13; // 16 bytes .. 64 KiB
+    static constexpr std::size_t max_block = min_block << (class_count - 1);
+
+    static BlockPool& instance()
+    {
+        static BlockPool pool;
+        return pool;
+    }
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    ~BlockPool()
+    {
+        for (auto head : free_lists)
+        {
+            while (head != nullptr)
+            {
+                FreeBlock* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+
+    void* allocate(std::size_t bytes)
+    {
+        if (bytes > max_block)
+        {
+            return ::operator new(bytes);
+        }
+
+        const std::size_t index = class_index(bytes);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            FreeBlock* head = free_lists[index];
+            if (head != nullptr)
+            {
+                free_lists[index] = head->next;
+                return head;
+            }
+        }
+        return ::operator new(min_block << index);
+    }
+
+    void deallocate(void* ptr, std::size_t bytes) noexcept
+    {
+        if (bytes > max_block)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        const std::size_t index = class_index(bytes);
+        std::lock_guard<std::mutex> guard(lock);
+        FreeBlock* node = static_cast<FreeBlock*>(ptr);
+        node->next = free_lists[index];
+        free_lists[index] = node;
+    }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    BlockPool() = default;
+
+    static std::size_t class_index(std::size_t bytes)
+    {
+        std::size_t index = 0;
+        while ((min_block << index) < bytes)
+        {
+            ++index;
+        }
+        return index;
+    }
+
+    std::mutex lock;
+    FreeBlock* free_lists[class_count] = {};
+};
+
+/// <summary>
+/// Stateless allocator over BlockPool.
+/// </summary>
+template <typename T>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(BlockPool::instance().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        BlockPool::instance().deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept
+{
+    return false;
+}
+
+// the containers CollectionTest runs against
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <typename T>
+using PoolVector = std::vector<T, PoolAllocator<T>>;
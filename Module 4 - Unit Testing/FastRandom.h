@@ -0,0 +1,332 @@
+// FastRandom.h : Seedable per-thread random numbers for the unit tests.
+//
+// Replaces rand(): no hidden shared state, no modulo bias, reproducible from a logged seed,
+// and a bulk fill that runs several generator lanes side by side so large fixtures fill fast.
+//
+
+#pragma once
+
+#include <atomic>       // std::atomic
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint32_t, std::uint64_t
+
+// SSE2 is part of every x64 target, and opt-in on 32 bit x86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAST_RANDOM_SSE2 1
+#include <emmintrin.h>  // _mm_mul_epu32, _mm_slli_epi64
+#endif
+
+/// <summary>
+/// SplitMix64 step. Used to expand one 64 bit seed into generator state, as the xoshiro
+/// authors recommend, and to mix seeds together.
+/// </summary>
+inline std::uint64_t splitmix64(std::uint64_t& state)
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/// <summary>
+/// xoshiro256++ generator (Blackman and Vigna). Small, fast and statistically solid for
+/// test data; not suitable for anything security related.
+/// </summary>
+class Xoshiro256
+{
+public:
+    explicit Xoshiro256(std::uint64_t seed = 0)
+    {
+        reseed(seed);
+    }
+
+    void reseed(std::uint64_t seed)
+    {
+        for (auto& word : state)
+        {
+            word = splitmix64(seed);
+        }
+    }
+
+    std::uint64_t next()
+    {
+        const std::uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+        const std::uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    /// <summary>
+    /// Unbiased integer in [0, range) using Lemire's multiply and reject method.
+    /// </summary>
+    std::uint32_t below(std::uint32_t range)
+    {
+        const std::uint32_t threshold = static_cast<std::uint32_t>(0u - range) % range;
+        for (;;)
+        {
+            const std::uint64_t m = (next() >> 32) * range;
+            if (static_cast<std::uint32_t>(m) >= threshold)
+            {
+                return static_cast<std::uint32_t>(m >> 32);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Unbiased integer in [lo, hi], both ends included.
+    /// </summary>
+    int uniform(int lo, int hi)
+    {
+        const std::uint32_t range = span_of(lo, hi);
+        const std::uint32_t offset = range == 0 ? static_cast<std::uint32_t>(next() >> 32) : below(range);
+        return static_cast<int>(static_cast<std::uint32_t>(lo) + offset);
+    }
+
+    /// <summary>
+    /// Fill count ints with unbiased values in [lo, hi].
+    ///
+    /// Four generator lanes, each jumped 2^128 steps apart so their streams never overlap, run
+    /// in lockstep and each 64 bit output supplies two values. With SSE2 two lanes share a
+    /// register; without it the same lanes run as plain integers and produce identical values,
+    /// so a seed replays the same data on every build.
+    /// </summary>
+    void fill(int* data, std::size_t count, int lo, int hi)
+    {
+        // small fills, and the full int range (where every 32 bit value is already in range)
+        const std::uint32_t range = span_of(lo, hi);
+        if (count < 16 * block || range == 0)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                data[i] = uniform(lo, hi);
+            }
+            return;
+        }
+
+        // lane l uses words[0..3][l]
+        std::uint64_t words[4][lanes];
+        for (std::size_t lane = 0; lane < lanes; ++lane)
+        {
+            jump();
+            for (int k = 0; k < 4; ++k)
+            {
+                words[k][lane] = state[k];
+            }
+        }
+        // move this generator past the streams handed to the lanes
+        jump();
+
+        const std::size_t done = fill_blocks(words, data, count / block, lo, hi) * block;
+        for (std::size_t i = done; i < count; ++i)
+        {
+            data[i] = uniform(lo, hi);
+        }
+    }
+
+    /// <summary>
+    /// Equivalent to 2^128 calls to next(); used to split one seed into non-overlapping streams.
+    /// </summary>
+    void jump()
+    {
+        static const std::uint64_t polynomial[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+        std::uint64_t jumped[4] = { 0, 0, 0, 0 };
+        for (auto word : polynomial)
+        {
+            for (int bit = 0; bit < 64; ++bit)
+            {
+                if (word & (std::uint64_t(1) << bit))
+                {
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        jumped[k] ^= state[k];
+                    }
+                }
+                next();
+            }
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            state[k] = jumped[k];
+        }
+    }
+
+private:
+    // lanes run by fill(), and the values one step of all lanes produces
+    static const std::size_t lanes = 4;
+    static const std::size_t block = lanes * 2;
+
+    // the multiply and shift mapping can favour some values by up to 1 / 2^32; values whose
+    // low product bits fall under the threshold are redrawn (block holds the lane outputs)
+    void redraw_biased(int* data, const std::uint64_t* outputs, int lo, int hi)
+    {
+        const std::uint32_t range = span_of(lo, hi);
+        const std::uint32_t threshold = static_cast<std::uint32_t>(0u - range) % range;
+        for (std::size_t k = 0; k < block; ++k)
+        {
+            const std::uint64_t bits = k % 2 == 0 ? (outputs[k / 2] & 0xffffffffULL) : (outputs[k / 2] >> 32);
+            if (static_cast<std::uint32_t>(bits * range) < threshold)
+            {
+                data[k] = uniform(lo, hi);
+            }
+        }
+    }
+
+#ifdef FAST_RANDOM_SSE2
+    static __m128i rotl(__m128i x, int k)
+    {
+        return _mm_or_si128(_mm_slli_epi64(x, k), _mm_srli_epi64(x, 64 - k));
+    }
+
+    // xoshiro256++ step for two lanes at once, returns their outputs
+    static __m128i step(__m128i& s0, __m128i& s1, __m128i& s2, __m128i& s3)
+    {
+        const __m128i result = _mm_add_epi64(rotl(_mm_add_epi64(s0, s3), 23), s0);
+        const __m128i t = _mm_slli_epi64(s1, 17);
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = rotl(s3, 45);
+        return result;
+    }
+
+    // fill `blocks` blocks of 8 values; returns how many were filled
+    std::size_t fill_blocks(std::uint64_t (&words)[4][lanes], int* data, std::size_t blocks, int lo, int hi)
+    {
+        const std::uint32_t range = span_of(lo, hi);
+        const std::uint32_t threshold = static_cast<std::uint32_t>(0u - range) % range;
+        const __m128i multiplier = _mm_set1_epi32(static_cast<int>(range));
+        const __m128i base = _mm_set1_epi32(lo);
+        // unsigned compare through a signed one: flip the sign bits of both sides
+        const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000u));
+        const __m128i limit = _mm_set1_epi32(static_cast<int>(threshold ^ 0x80000000u));
+        const __m128i odd_words = _mm_set_epi32(-1, 0, -1, 0);
+
+        __m128i a[4], b[4];
+        for (int k = 0; k < 4; ++k)
+        {
+            a[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&words[k][0]));
+            b[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&words[k][2]));
+        }
+
+        // two lanes of output to four values: [low half, high half] of each lane, scaled to range
+        auto map = [&](__m128i out, __m128i& rejected)
+        {
+            const __m128i low_products = _mm_mul_epu32(out, multiplier);
+            const __m128i high_products = _mm_mul_epu32(_mm_srli_epi64(out, 32), multiplier);
+            const __m128i values = _mm_or_si128(_mm_srli_epi64(low_products, 32), _mm_and_si128(high_products, odd_words));
+            const __m128i fractions = _mm_or_si128(_mm_andnot_si128(odd_words, low_products), _mm_slli_epi64(high_products, 32));
+            rejected = _mm_or_si128(rejected, _mm_cmplt_epi32(_mm_xor_si128(fractions, sign), limit));
+            return _mm_add_epi32(values, base);
+        };
+
+        for (std::size_t n = 0; n < blocks; ++n, data += block)
+        {
+            const __m128i first = step(a[0], a[1], a[2], a[3]);
+            const __m128i second = step(b[0], b[1], b[2], b[3]);
+
+            __m128i rejected = _mm_setzero_si128();
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data), map(first, rejected));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 4), map(second, rejected));
+
+            if (_mm_movemask_epi8(rejected) != 0)
+            {
+                std::uint64_t outputs[lanes];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&outputs[0]), first);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&outputs[2]), second);
+                redraw_biased(data, outputs, lo, hi);
+            }
+        }
+        return blocks;
+    }
+#else
+    // portable version of the SSE2 loop above, same lanes and same value order
+    std::size_t fill_blocks(std::uint64_t (&words)[4][lanes], int* data, std::size_t blocks, int lo, int hi)
+    {
+        const std::uint32_t range = span_of(lo, hi);
+        const std::uint32_t threshold = static_cast<std::uint32_t>(0u - range) % range;
+        const std::uint32_t base = static_cast<std::uint32_t>(lo);
+
+        for (std::size_t n = 0; n < blocks; ++n, data += block)
+        {
+            std::uint64_t outputs[lanes];
+            std::uint32_t rejected = 0;
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+            {
+                std::uint64_t& s0 = words[0][lane];
+                std::uint64_t& s1 = words[1][lane];
+                std::uint64_t& s2 = words[2][lane];
+                std::uint64_t& s3 = words[3][lane];
+                outputs[lane] = rotl(s0 + s3, 23) + s0;
+                const std::uint64_t t = s1 << 17;
+                s2 ^= s0;
+                s3 ^= s1;
+                s1 ^= s2;
+                s0 ^= s3;
+                s2 ^= t;
+                s3 = rotl(s3, 45);
+
+                const std::uint64_t low = (outputs[lane] & 0xffffffffULL) * range;
+                const std::uint64_t high = (outputs[lane] >> 32) * range;
+                data[lane * 2] = static_cast<int>(base + static_cast<std::uint32_t>(low >> 32));
+                data[lane * 2 + 1] = static_cast<int>(base + static_cast<std::uint32_t>(high >> 32));
+                rejected |= static_cast<std::uint32_t>(static_cast<std::uint32_t>(low) < threshold)
+                          | static_cast<std::uint32_t>(static_cast<std::uint32_t>(high) < threshold);
+            }
+
+            if (rejected)
+            {
+                redraw_biased(data, outputs, lo, hi);
+            }
+        }
+        return blocks;
+    }
+#endif
+
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // number of values in [lo, hi] modulo 2^32 (0 for the full int range)
+    static std::uint32_t span_of(int lo, int hi)
+    {
+        return static_cast<std::uint32_t>(static_cast<std::uint32_t>(hi) - static_cast<std::uint32_t>(lo) + 1u);
+    }
+
+    std::uint64_t state[4];
+};
+
+// process-wide seed every thread's generator is derived from
+inline std::atomic<std::uint64_t>& random_base_seed()
+{
+    static std::atomic<std::uint64_t> seed{ 0 };
+    return seed;
+}
+
+/// <summary>
+/// Combine the base seed with a value (thread number, hashed test name, ...) into a new seed.
+/// </summary>
+inline std::uint64_t derive_seed(std::uint64_t base, std::uint64_t salt)
+{
+    std::uint64_t mixed = base ^ (salt * 0x9e3779b97f4a7c15ULL);
+    return splitmix64(mixed);
+}
+
+/// <summary>
+/// This thread's generator. Each thread starts from random_base_seed() mixed with the order in
+/// which threads first asked for one; call reseed() on it for a stream tied to a specific test.
+/// </summary>
+inline Xoshiro256& thread_random()
+{
+    static std::atomic<std::uint64_t> threads{ 0 };
+    thread_local Xoshiro256 generator(derive_seed(random_base_seed().load(), threads++));
+    return generator;
+}
@@ -2,9 +2,18 @@
 #include "pch.h"
 // uncomment the next line if you do not use precompiled headers
 //#include "gtest/gtest.h"
+#include <algorithm>    // std::min, std::minmax_element
+#include <cstdlib>      // std::getenv, std::strtoull
+#include <iostream>     // std::cout
+#include <random>       // std::random_device
+#include <sstream>      // std::ostringstream
+#include "Collections.h"
+// build with COUNT_HEAP_ALLOCATIONS defined to also count every heap allocation in the test binary,
+// not just the ones made through CountingAllocator
+#include "AllocationCounter.h"
+#include "FastRandom.h"
 //
 // the global test environment setup and tear down
-// you should not need to change anything here
 class Environment : public ::testing::Environment
 {
 public:
@@ -13,29 +22,83 @@ public:
     // Override this to define how to set up the environment.
     void SetUp() override
     {
-        //  initialize random seed
-        srand(time(nullptr));
+        //  initialize random seed, from COLLECTION_TEST_SEED when replaying a run
+        std::uint64_t seed = 0;
+        const char* replay = std::getenv("COLLECTION_TEST_SEED");
+        if (replay != nullptr)
+        {
+            seed = std::strtoull(replay, nullptr, 10);
+        }
+        else
+        {
+            std::random_device device;
+            seed = (std::uint64_t(device()) << 32) ^ device() ^ static_cast<std::uint64_t>(time(nullptr));
+        }
+        random_base_seed() = seed;
+
+        // log the seed so a failing run can be reproduced
+        std::cout << "[  SEED    ] COLLECTION_TEST_SEED=" << seed << std::endl;
+
+        // each shard of a parallel run sets up its own environment; per test seeds only depend on
+        // the base seed and the test name, so a test draws the same values whichever shard runs it
+        const char* shard = shard_variable("GTEST_SHARD_INDEX", "COLLECTION_TEST_SHARD_INDEX");
+        const char* shards = shard_variable("GTEST_TOTAL_SHARDS", "COLLECTION_TEST_TOTAL_SHARDS");
+        if (shard != nullptr && shards != nullptr)
+        {
+            std::cout << "[  SHARD   ] " << shard << " of " << shards << std::endl;
+        }
     }
 
     // Override this to define how to tear down the environment.
     void TearDown() override {}
+
+private:
+    // gtest's own sharding variable, or the launcher's when it hands out explicit test lists
+    static const char* shard_variable(const char* gtest_name, const char* launcher_name)
+    {
+        const char* value = std::getenv(gtest_name);
+        return value != nullptr ? value : std::getenv(launcher_name);
+    }
 };
 
+// register the environment with gtest_main
+::testing::Environment* const collection_environment = ::testing::AddGlobalTestEnvironment(new Environment);
+
 // create our test class to house shared data between tests
-// you should not need to change anything here
+// the fixture is typed so every test runs against each container in CollectionTypes
+template <typename Collection>
 class CollectionTest : public ::testing::Test
 {
 protected:
     // create a smart point to hold our collection
-    std::unique_ptr<std::vector<int>> collection;
+    std::unique_ptr<Collection> collection;
+
+    // allocations made during the test body
+    AllocationScope allocations;
 
     void SetUp() override
-    { // create a new collection to be used in the test
-        collection.reset(new std::vector<int>);
+    { // give every test its own random stream, so it replays the same on its own or in any order
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        std::uint64_t name_hash = 14695981039346656037ULL;
+        for (const char* c : { info->test_suite_name(), ".", info->name() })
+        {
+            for (; *c != '\0'; ++c)
+            {
+                name_hash = (name_hash ^ static_cast<unsigned char>(*c)) * 1099511628211ULL;
+            }
+        }
+        thread_random().reseed(derive_seed(random_base_seed().load(), name_hash));
+
+        // create a new collection to be used in the test
+        collection.reset(new Collection);
+        // start counting once the fixture itself is built
+        allocations.reset();
     }
 
     void TearDown() override
-    { //  erase all elements in the collection, if any remain
+    { // report what the test allocated before anything is freed
+        report_allocations();
+        //  erase all elements in the collection, if any remain
         collection->clear();
         // free the pointer
         collection.reset(nullptr);
@@ -45,336 +108,512 @@ protected:
     void add_entries(int count)
     {
         assert(count > 0);
-        for (auto i = 0; i < count; ++i)
-            collection->push_back(rand() % 100);
+
+        // draw the values in chunks, but still add them one push_back at a time
+        int values[64];
+        for (auto done = 0; done < count; done += 64)
+        {
+            const auto chunk = std::min(count - done, 64);
+            thread_random().fill(values, chunk, 0, 99);
+            for (auto i = 0; i < chunk; ++i)
+                collection->push_back(values[i]);
+        }
+    }
+
+    // helper function for large collections: grow once and bulk fill count random values from 0 to 99
+    void fill_entries(std::size_t count)
+    {
+        const auto old_size = collection->size();
+        collection->resize(old_size + count);
+        thread_random().fill(collection->data() + old_size, count, 0, 99);
+    }
+
+    // add the allocation totals to the XML / JSON report and the console output: the container's
+    // own requests when it runs on CountingAllocator, every heap allocation when the global hook
+    // is compiled in
+    void report_allocations()
+    {
+        const bool counted_container = is_counting_allocator<typename Collection::allocator_type>::value;
+
+        // read everything first, reporting allocates too
+        const auto count = allocations.allocations();
+        const auto bytes = allocations.bytes();
+        const auto heap_count = allocations.heap_allocations();
+        const auto heap_bytes = allocations.heap_bytes();
+
+        std::ostringstream line;
+        if (counted_container)
+        {
+            RecordProperty("allocations", std::to_string(count));
+            RecordProperty("allocated_bytes", std::to_string(bytes));
+            line << count << " allocation(s), " << bytes << " bytes";
+        }
+#ifdef COUNT_HEAP_ALLOCATIONS
+        RecordProperty("heap_allocations", std::to_string(heap_count));
+        RecordProperty("heap_bytes", std::to_string(heap_bytes));
+        line << (counted_container ? " (" : "") << heap_count << " heap allocation(s), " << heap_bytes << " bytes"
+             << (counted_container ? ")" : "");
+#else
+        static_cast<void>(heap_count);
+        static_cast<void>(heap_bytes);
+        if (!counted_container)
+        {
+            line << "not counted, build with COUNT_HEAP_ALLOCATIONS to count heap allocations";
+        }
+#endif
+        std::cout << "[  ALLOCS  ] " << line.str() << std::endl;
+    }
+};
+
+// the counted variant of each container, for the tests that assert exact allocation counts
+template <typename Collection>
+class CountedCollectionTest : public CollectionTest<typename counted<Collection>::type>
+{
+};
+
+// the containers that must be drop-in compatible with std::vector<int>
+using CollectionTypes = ::testing::Types<
+    std::vector<int>,
+    SmallVector<int, 8>,
+    ArenaVector<int>,
+    PoolVector<int>>;
+
+// readable suffixes for the typed test names, in CollectionTypes order
+class CollectionNames
+{
+public:
+    template <typename T>
+    static std::string GetName(int index)
+    {
+        static const char* const names[] = { "StdVector", "SmallVector", "ArenaVector", "PoolVector" };
+        return names[index];
     }
 };
 
+TYPED_TEST_SUITE(CollectionTest, CollectionTypes, CollectionNames);
+TYPED_TEST_SUITE(CountedCollectionTest, CollectionTypes, CollectionNames);
+
 // When should you use the EXPECT_xxx or ASSERT_xxx macros?
 // Use ASSERT when failure should terminate processing, such as the reason for the test case.
 // Use EXPECT when failure should notify, but processing should continue
 
 // Test that a collection is empty when created.
-// Prior to calling this (and all other TEST_F defined methods),
+// Prior to calling this (and all other TYPED_TEST defined methods),
 //  CollectionTest::StartUp is called.
-// Following this method (and all other TEST_F defined methods),
+// Following this method (and all other TYPED_TEST defined methods),
 //  CollectionTest::TearDown is called
-TEST_F(CollectionTest, CollectionSmartPointerIsNotNull)
+TYPED_TEST(CollectionTest, CollectionSmartPointerIsNotNull)
 {
     // is the collection created
-    ASSERT_TRUE(collection);
+    ASSERT_TRUE(this->collection);
 
     // if empty, the size must be 0
-    ASSERT_NE(collection.get(), nullptr);
+    ASSERT_NE(this->collection.get(), nullptr);
 }
 
 // Test that a collection is empty when created.
-TEST_F(CollectionTest, IsEmptyOnCreate)
+TYPED_TEST(CollectionTest, IsEmptyOnCreate)
 {
     // is the collection empty?
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if empty, the size must be 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 }
 
 /* Comment this test out to prevent the test from running
  * Uncomment this test to see a failure in the test explorer 
-TEST_F(CollectionTest, AlwaysFail)
+TYPED_TEST(CollectionTest, AlwaysFail)
 {
     FAIL();
 }
 */
 
 // Create a test to verify adding a single value to an empty collection
-TEST_F(CollectionTest, CanAddToEmptyVector)
+TYPED_TEST(CollectionTest, CanAddToEmptyVector)
 {
     // is the collection empty?
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if empty, the size must be 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
-    add_entries(1);
+    this->add_entries(1);
 
     // is the collection still empty?
-    ASSERT_FALSE(collection->empty());
+    ASSERT_FALSE(this->collection->empty());
 
     // if not empty, what must the size be?
-    ASSERT_EQ(collection->size(), 1);
+    ASSERT_EQ(this->collection->size(), 1);
 }
 
 // Create a test to verify adding five values to collection
-TEST_F(CollectionTest, CanAddFiveValuesToVector)
+TYPED_TEST(CollectionTest, CanAddFiveValuesToVector)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // add 5 entries
-    add_entries(5);
+    this->add_entries(5);
 
     // verify collection size is 5
-    ASSERT_EQ(collection->size(), 5);
+    ASSERT_EQ(this->collection->size(), 5);
 
 }
 
 // Create a test to verify that max size is greater than or equal to size for 0, 1, 5, 10 entries
-TEST_F(CollectionTest, MaxSizeGreaterThanSize)
+TYPED_TEST(CollectionTest, MaxSizeGreaterThanSize)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // verify max size is greater than or equal to size 0
-    ASSERT_GE(collection->max_size(), collection->size());
+    ASSERT_GE(this->collection->max_size(), this->collection->size());
 
     // add 1 entry
-    add_entries(1);
+    this->add_entries(1);
 
     // verify max size is greater than or equal to size 1
-    ASSERT_GE(collection->max_size(), collection->size());
+    ASSERT_GE(this->collection->max_size(), this->collection->size());
 
     //clear collection 
-    collection->clear();
+    this->collection->clear();
 
     // add 5 entries
-    add_entries(5);
+    this->add_entries(5);
 
     // verify max size is greater than or equal to size 5
-    ASSERT_GE(collection->max_size(), collection->size());
+    ASSERT_GE(this->collection->max_size(), this->collection->size());
 
     //clear collection
-    collection->clear();
+    this->collection->clear();
 
     //add 10 entries
-    add_entries(10);
+    this->add_entries(10);
 
     // verify max size is greater than or equal to size 10
-    ASSERT_GE(collection->max_size(), collection->size());
+    ASSERT_GE(this->collection->max_size(), this->collection->size());
 
 }
 
 // Create a test to verify that capacity is greater than or equal to size for 0, 1, 5, 10 entries
-TEST_F(CollectionTest, CapacityGreaterThanSize)
+TYPED_TEST(CollectionTest, CapacityGreaterThanSize)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // verify capacity is greater than or equal to size 0
-    ASSERT_GE(collection->capacity(), collection->size());
+    ASSERT_GE(this->collection->capacity(), this->collection->size());
 
     // add 1 entry
-    add_entries(1);
+    this->add_entries(1);
 
     // verify capacity is greater than or equal to size 1
-    ASSERT_GE(collection->capacity(), collection->size());
+    ASSERT_GE(this->collection->capacity(), this->collection->size());
 
     //clear collection 
-    collection->clear();
+    this->collection->clear();
 
     // add 5 entries
-    add_entries(5);
+    this->add_entries(5);
 
     // verify capacity is greater than or equal to size 5
-    ASSERT_GE(collection->capacity(), collection->size());
+    ASSERT_GE(this->collection->capacity(), this->collection->size());
 
     //clear collection
-    collection->clear();
+    this->collection->clear();
 
     //add 10 entries
-    add_entries(10);
+    this->add_entries(10);
 
     // verify capacity is greater than or equal to size 10
-    ASSERT_GE(collection->capacity(), collection->size());
+    ASSERT_GE(this->collection->capacity(), this->collection->size());
 }
 
 // Create a test to verify resizing increases the collection
-TEST_F(CollectionTest, ResizeIncreasesSize)
+TYPED_TEST(CollectionTest, ResizeIncreasesSize)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     //resize collection
-    collection->resize(10);
+    this->collection->resize(10);
 
     // verify collection is still empty
-    ASSERT_FALSE(collection->empty());
+    ASSERT_FALSE(this->collection->empty());
 
     // if not empty, verify resize increased size
-    ASSERT_EQ(collection->size(), 10);
+    ASSERT_EQ(this->collection->size(), 10);
 
 }
 
 // Create a test to verify resizing decreases the collection
-TEST_F(CollectionTest, ResizeDecreasesSize)
+TYPED_TEST(CollectionTest, ResizeDecreasesSize)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // add 20 entries
-    add_entries(20);
+    this->add_entries(20);
 
     // verify collection size is 20
-    ASSERT_EQ(collection->size(), 20);
+    ASSERT_EQ(this->collection->size(), 20);
 
     // resize collection to 10 entries
-    collection->resize(10);
+    this->collection->resize(10);
 
     // verify collection size is now 10
-    ASSERT_EQ(collection->size(), 10);
+    ASSERT_EQ(this->collection->size(), 10);
 }
 
 // Create a test to verify resizing decreases the collection to zero
-TEST_F(CollectionTest, ResizeDecreasesToZero)
+TYPED_TEST(CollectionTest, ResizeDecreasesToZero)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // add 10 entries
-    add_entries(10);
+    this->add_entries(10);
 
     // verify collection size is 10
-    ASSERT_EQ(collection->size(), 10);
+    ASSERT_EQ(this->collection->size(), 10);
 
     // resize collection to 0 entries
-    collection->resize(0);
+    this->collection->resize(0);
 
     // verify collection size is now 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 }
 
 // Create a test to verify clear erases the collection
-TEST_F(CollectionTest, ClearErasesCollection)
+TYPED_TEST(CollectionTest, ClearErasesCollection)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // add 10 entries
-    add_entries(10);
+    this->add_entries(10);
 
     // verify collection size is 10
-    ASSERT_EQ(collection->size(), 10);
+    ASSERT_EQ(this->collection->size(), 10);
 
     // clear collection
-    collection->clear();
+    this->collection->clear();
 
     // verify collection size is now 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 }
 
 // Create a test to verify erase(begin,end) erases the collection
-TEST_F(CollectionTest, EraseErasesCollection)
+TYPED_TEST(CollectionTest, EraseErasesCollection)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // add 10 entries
-    add_entries(10);
+    this->add_entries(10);
 
     // verify collection size is 10
-    ASSERT_EQ(collection->size(), 10);
+    ASSERT_EQ(this->collection->size(), 10);
 
     // erase collection from beginning to end
-    collection->erase(collection->begin(), collection->end());
+    this->collection->erase(this->collection->begin(), this->collection->end());
 
     // verify collection size is now 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 }
 
 // Create a test to verify reserve increases the capacity but not the size of the collection
-TEST_F(CollectionTest, ReserveIncreasesCapacityNotSize)
+TYPED_TEST(CollectionTest, ReserveIncreasesCapacityNotSize)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // reserve 10 entries
-    collection->reserve(10);
+    this->collection->reserve(10);
 
     // verify capacity is 10 now
-    ASSERT_EQ(collection->capacity(), 10);
+    ASSERT_EQ(this->collection->capacity(), 10);
 
     // verify size is still 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
+}
+
+// Create a test to verify reserve on an empty collection allocates exactly once
+TYPED_TEST(CountedCollectionTest, ReserveAllocatesOnce)
+{
+    // verify collection is empty
+    ASSERT_TRUE(this->collection->empty());
+
+    // reserve 10 entries
+    this->collection->reserve(10);
+
+    // verify reserve took exactly one allocation
+    ASSERT_EQ(this->allocations.allocations(), 1);
+}
+
+// Create a test to verify push_back within reserved capacity never reallocates
+TYPED_TEST(CountedCollectionTest, ReserveThenAddDoesNotReallocate)
+{
+    // verify collection is empty
+    ASSERT_TRUE(this->collection->empty());
+
+    // reserve 10 entries
+    this->collection->reserve(10);
+
+    // count only what happens after the reserve
+    AllocationScope scope;
+
+    // add 10 entries
+    this->add_entries(10);
+
+    // verify collection size is 10
+    ASSERT_EQ(this->collection->size(), 10);
+
+    // verify no allocation happened while adding
+    ASSERT_EQ(scope.allocations(), 0);
+}
+
+// Create a test to verify resizing an empty collection allocates exactly once
+TYPED_TEST(CountedCollectionTest, ResizeAllocatesOnce)
+{
+    // verify collection is empty
+    ASSERT_TRUE(this->collection->empty());
+
+    // resize collection to 100 entries
+    this->collection->resize(100);
+
+    // verify collection size is 100
+    ASSERT_EQ(this->collection->size(), 100);
+
+    // verify one allocation big enough for all 100 entries
+    ASSERT_EQ(this->allocations.allocations(), 1);
+    ASSERT_GE(this->allocations.bytes(), 100 * sizeof(int));
+}
+
+// Create a test to verify a large collection can be filled with in-range values
+TYPED_TEST(CollectionTest, CanFillTenMillionEntries)
+{
+    // verify collection is empty
+    ASSERT_TRUE(this->collection->empty());
+
+    // fill 10 million entries
+    this->fill_entries(10000000);
+
+    // verify collection size is 10 million
+    ASSERT_EQ(this->collection->size(), 10000000);
+
+    // verify every value is between 0 and 99
+    const auto bounds = std::minmax_element(this->collection->begin(), this->collection->end());
+    ASSERT_GE(*bounds.first, 0);
+    ASSERT_LE(*bounds.second, 99);
 }
 
 // Create a test to verify the std::out_of_range exception is thrown when calling at() with an index out of bounds
 // NOTE: This is a negative test
-TEST_F(CollectionTest, OutOfRangeExceptionThrown)
+TYPED_TEST(CollectionTest, OutOfRangeExceptionThrown)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // verify exception thrown with out of bound index call
-    ASSERT_THROW(collection->at(1), std::out_of_range);
+    ASSERT_THROW(this->collection->at(1), std::out_of_range);
 
 }
 
 /* Create 2 of my own tests */
 
 // Create test to verify assigning value at index changes value at given index
-TEST_F(CollectionTest, AssignChangesValueAtIndex)
+TYPED_TEST(CollectionTest, AssignChangesValueAtIndex)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     // add 10 entries
-    add_entries(10);
+    this->add_entries(10);
 
-    // assign 20 at index 1
-    collection->assign(collection->at(1), 20);
+    // assign 20 to every entry; the count is the current size, not a random value read from the
+    // collection, which shrank it below 2 entries whenever that value was 0 or 1
+    this->collection->assign(this->collection->size(), 20);
 
-    // verify value at index 1 is 20
-    ASSERT_EQ(collection->at(1), 20);
+    // verify value at index 1 is 20 and the size did not change
+    ASSERT_EQ(this->collection->size(), 10);
+    ASSERT_EQ(this->collection->at(1), 20);
 
-    // assign 15 at index 1
-    collection->assign(collection->at(1), 15);
+    // assign 15 to every entry
+    this->collection->assign(this->collection->size(), 15);
 
     // verify value at index 1 is now 15
-    ASSERT_EQ(collection->at(1), 15);
+    ASSERT_EQ(this->collection->size(), 10);
+    ASSERT_EQ(this->collection->at(1), 15);
 
 }
 
 // Create test to verify that std::length_error exception is thrown when max size exceeded
-TEST_F(CollectionTest, LengthErrorExceptionThrown)
+TYPED_TEST(CollectionTest, LengthErrorExceptionThrown)
 {
     // verify collection is empty
-    ASSERT_TRUE(collection->empty());
+    ASSERT_TRUE(this->collection->empty());
 
     // if collection empty, size is 0
-    ASSERT_EQ(collection->size(), 0);
+    ASSERT_EQ(this->collection->size(), 0);
 
     //verify exception thrown when max size exceeded
-    ASSERT_THROW(collection->resize(collection->max_size() + 1), std::length_error);
+    ASSERT_THROW(this->collection->resize(this->collection->max_size() + 1), std::length_error);
+}
+
+// Create test to verify that moving a SmallVector on an arena takes over its heap storage
+TEST(SmallVectorTest, MoveConstructorTakesArenaStorage)
+{
+    // grow past the inline buffer so the elements live in the arena
+    SmallVector<int, 8, ArenaAllocator<int>> source;
+    for (int i = 0; i < 20; ++i)
+        source.push_back(i);
+    const int* storage = source.data();
+
+    SmallVector<int, 8, ArenaAllocator<int>> moved(std::move(source));
+
+    // verify the storage changed hands instead of being copied
+    ASSERT_EQ(moved.data(), storage);
+    ASSERT_EQ(moved.size(), 20);
+    ASSERT_EQ(moved.at(19), 19);
+
+    // verify the moved from collection is empty and can still grow
+    ASSERT_TRUE(source.empty());
+    for (int i = 0; i < 20; ++i)
+        source.push_back(i);
+    ASSERT_EQ(source.size(), 20);
 }
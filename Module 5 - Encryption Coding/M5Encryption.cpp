@@ -1,20 +1,1802 @@
 // M5Encryption.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
 
-#include <iostream>
+#include <algorithm>    // std::min, std::max
+#include <array>        // std::array
+#include <chrono>       // std::chrono::steady_clock
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint8_t, std::uintptr_t
+#include <cstring>      // std::memset
+#include <iostream>     // std::cout, std::cerr
+#include <limits>       // std::numeric_limits
+#include <mutex>        // std::mutex, std::lock_guard
+#include <new>          // std::bad_alloc
+#include <random>       // std::mt19937
+#include <stdexcept>    // std::invalid_argument
+#include <string>       // std::string, std::basic_string
+#include <vector>       // std::vector
 
-int main()
+#ifdef _WIN32
+// keep windows.h from defining min / max macros over std::min and std::numeric_limits::max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    // VirtualAlloc, VirtualLock, SecureZeroMemory
+#else
+#include <sys/mman.h>       // mmap, mlock, madvise
+#include <sys/resource.h>   // getrlimit
+#include <unistd.h>         // sysconf
+#endif
+
+// SSSE3 kernels for Base64 / hex, built on every x86 target. With -mssse3 (or -march=native) or
+// /arch:AVX they always run; otherwise they are compiled for SSSE3 on their own (M5_SSSE3) and
+// picked at run time when the CPU supports it, so a default build still gets them
+#if defined(__SSSE3__) || defined(__AVX__)
+#define M5_HAVE_SSSE3 1
+#define M5_SSSE3
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define M5_HAVE_SSSE3 1
+#define M5_SSSE3_DISPATCH 1
+#define M5_SSSE3 __attribute__((target("ssse3")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define M5_HAVE_SSSE3 1
+#define M5_SSSE3_DISPATCH 1
+#define M5_SSSE3
+#include <intrin.h>     // __cpuid
+#endif
+#ifdef M5_HAVE_SSSE3
+#include <tmmintrin.h>  // _mm_shuffle_epi8, _mm_maddubs_epi16
+#endif
+
+// HOT_PATH_TIMER, compiled in only with HOT_PATH_TIMING defined
+#include "../Common/Instrumentation.h"
+
+/// <summary>
+/// Overwrite a block of memory with zeros in a way the optimizer is not allowed to remove.
+/// A plain memset on memory that is about to be freed is a dead store and is routinely dropped.
+/// </summary>
+/// <param name="ptr">Start of the block</param>
+/// <param name="bytes">Number of bytes to clear</param>
+void secure_zero(void* ptr, std::size_t bytes)
+{
+#if defined(_WIN32)
+    SecureZeroMemory(ptr, bytes);
+#elif defined(__GNUC__) || defined(__clang__)
+    std::memset(ptr, 0, bytes);
+    // compiler barrier: the asm claims to read the block, so the memset must happen
+    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+#else
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(ptr);
+    while (bytes--)
+    {
+        *p++ = 0;
+    }
+#endif
+}
+
+/// <summary>
+/// Pin a range of pages in RAM so the contents are never written to swap.
+/// </summary>
+/// <returns>true when the pages are locked</returns>
+bool lock_pages(void* ptr, std::size_t bytes)
+{
+#ifdef _WIN32
+    return VirtualLock(ptr, bytes) != 0;
+#else
+    return mlock(ptr, bytes) == 0;
+#endif
+}
+
+/// <summary>
+/// Release a range previously pinned with lock_pages.
+/// </summary>
+void unlock_pages(void* ptr, std::size_t bytes)
+{
+#ifdef _WIN32
+    VirtualUnlock(ptr, bytes);
+#else
+    munlock(ptr, bytes);
+#endif
+}
+
+/// <summary>
+/// Size of a virtual memory page on this machine.
+/// </summary>
+std::size_t page_size()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<std::size_t>(info.dwPageSize);
+#else
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/// <summary>
+/// How many bytes this process may lock: RLIMIT_MEMLOCK on POSIX (64 KiB on many systems),
+/// part of the minimum working set on Windows, which is what VirtualLock is limited by.
+/// </summary>
+std::size_t lock_budget()
+{
+#ifdef _WIN32
+    SIZE_T minimum = 0;
+    SIZE_T maximum = 0;
+    if (!GetProcessWorkingSetSize(GetCurrentProcess(), &minimum, &maximum))
+    {
+        return 0;
+    }
+    // the process needs most of its minimum working set for itself
+    return static_cast<std::size_t>(minimum / 2);
+#else
+    rlimit limit{};
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) != 0)
+    {
+        return 0;
+    }
+    if (limit.rlim_cur == RLIM_INFINITY)
+    {
+        return (std::numeric_limits<std::size_t>::max)();
+    }
+    return static_cast<std::size_t>(limit.rlim_cur);
+#endif
+}
+
+/// <summary>
+/// Map a fresh, page aligned region straight from the OS and try to lock it.
+/// </summary>
+/// <param name="bytes">Region size, must be a multiple of the page size</param>
+/// <param name="locked">Set to whether the pages could be locked; the region is returned either way</param>
+/// <returns>The region or nullptr when it could not be mapped</returns>
+void* map_locked_region(std::size_t bytes, bool& locked)
+{
+#ifdef _WIN32
+    void* region = VirtualAlloc(nullptr, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (region == nullptr)
+    {
+        return nullptr;
+    }
+    locked = lock_pages(region, bytes);
+#else
+    void* region = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    locked = lock_pages(region, bytes);
+#ifdef MADV_DONTDUMP
+    // keep key material out of core dumps as well
+    madvise(region, bytes, MADV_DONTDUMP);
+#endif
+#endif
+    return region;
+}
+
+/// <summary>
+/// Zero, unlock and hand a region from map_locked_region back to the OS.
+/// </summary>
+void unmap_locked_region(void* region, std::size_t bytes)
+{
+    secure_zero(region, bytes);
+    unlock_pages(region, bytes);
+#ifdef _WIN32
+    VirtualFree(region, 0, MEM_RELEASE);
+#else
+    munmap(region, bytes);
+#endif
+}
+
+/// <summary>
+/// Pooled allocator for secrets (keys, plaintext scratch buffers).
+///
+/// Locking memory one allocation at a time costs a system call per new/delete, so instead the
+/// pool locks a few regions and carves them into power of two size classes. Regions start at
+/// a few pages and double, sized to fit the process's lock budget, so a single key does not
+/// need more locked memory than the OS allows. When locking fails anyway the pool warns once
+/// and carries on with unlocked (but still zeroed) memory.
+/// Freed blocks are zeroed immediately and kept on a per class free list for reuse.
+///
+/// Trade-offs: classes go up to 64 KiB, which covers keys, scratch buffers and the regrowth of a
+/// secure_bytes well past them; anything larger gets its own mapping (and pays the lock system
+/// calls) since it is rare and costs far more to fill than to lock. At most 4 MiB is pooled, and a
+/// freed block is only reused by its own class, so once that is reached a class with nothing free
+/// also falls back to a mapping of its own instead of failing.
+/// </summary>
+class SecurePool
+{
+public:
+    // smallest and largest pooled block, everything in between is a power of two
+    static constexpr std::size_t min_block = 16;
+    static constexpr std::size_t max_block = 64 * 1024;
+    static constexpr std::size_t class_count = 13; // 16, 32, ... 65536
+
+    // regions grow from 16 KiB to 1 MiB, at most 4 MiB pooled in total
+    static constexpr std::size_t min_region = 16 * 1024;
+    static constexpr std::size_t max_region = 1024 * 1024;
+    static constexpr std::size_t max_pooled = 4 * 1024 * 1024;
+
+    // usage counters, reported by the demo and benchmark
+    struct Stats
+    {
+        std::size_t regions = 0;
+        std::size_t unlocked_regions = 0;
+        std::size_t blocks_in_use = 0;
+        std::size_t bytes_in_use = 0;
+        std::size_t large_mappings = 0;
+    };
+
+    // one pool per process
+    static SecurePool& instance()
+    {
+        static SecurePool pool;
+        return pool;
+    }
+
+    SecurePool(const SecurePool&) = delete;
+    SecurePool& operator=(const SecurePool&) = delete;
+
+    ~SecurePool()
+    {
+        for (auto& region : regions)
+        {
+            unmap_locked_region(region.base, region.bytes);
+        }
+    }
+
+    /// <summary>
+    /// Get a zero filled block of at least bytes, locked whenever the OS allows it.
+    /// </summary>
+    /// <exception cref="std::bad_alloc">The OS has no memory left</exception>
+    void* allocate(std::size_t bytes)
+    {
+        HOT_PATH_TIMER("SecurePool::allocate");
+
+        if (bytes > max_block)
+        {
+            return allocate_large(bytes);
+        }
+
+        const std::size_t index = class_index(bytes);
+        const std::size_t block = class_size(index);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            FreeBlock* head = free_lists[index];
+            void* result = nullptr;
+            if (head != nullptr)
+            {
+                // reuse a freed block, it was zeroed on free apart from the link
+                free_lists[index] = head->next;
+                head->next = nullptr;
+                result = head;
+            }
+            else
+            {
+                result = carve(block);
+            }
+
+            if (result != nullptr)
+            {
+                ++stats.blocks_in_use;
+                stats.bytes_in_use += block;
+                return result;
+            }
+        }
+
+        // the pool is full; deallocate recognizes the block as not being in any region
+        return allocate_large(block);
+    }
+
+    /// <summary>
+    /// Zero and return a block. bytes must be the size passed to allocate.
+    /// </summary>
+    void deallocate(void* ptr, std::size_t bytes) noexcept
+    {
+        HOT_PATH_TIMER("SecurePool::deallocate");
+
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        if (bytes > max_block)
+        {
+            deallocate_large(ptr, bytes);
+            return;
+        }
+
+        const std::size_t index = class_index(bytes);
+        const std::size_t block = class_size(index);
+
+        // clear the whole block, not just what the caller asked for
+        secure_zero(ptr, block);
+
+        std::unique_lock<std::mutex> guard(lock);
+        if (stats.large_mappings > 0 && !in_region(ptr))
+        {
+            // a block that overflowed the full pool
+            guard.unlock();
+            deallocate_large(ptr, block);
+            return;
+        }
+        FreeBlock* node = static_cast<FreeBlock*>(ptr);
+        node->next = free_lists[index];
+        free_lists[index] = node;
+
+        --stats.blocks_in_use;
+        stats.bytes_in_use -= block;
+    }
+
+    Stats usage()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+private:
+    // freed blocks are threaded through their own storage
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    // one mapping blocks are carved from
+    struct Region
+    {
+        void* base;
+        std::size_t bytes;
+        bool locked;
+    };
+
+    SecurePool() : budget(lock_budget()) {}
+
+    // tell the user once that secrets may reach swap
+    static void warn_unlocked()
+    {
+        static bool warned = false;
+        if (!warned)
+        {
+            warned = true;
+            std::cerr << "Warning: secure memory could not be locked (memlock limit too low?), "
+                         "secrets may be written to swap" << std::endl;
+        }
+    }
+
+    static std::size_t class_index(std::size_t bytes)
+    {
+        std::size_t index = 0;
+        std::size_t block = min_block;
+        while (block < bytes)
+        {
+            block <<= 1;
+            ++index;
+        }
+        return index;
+    }
+
+    static std::size_t class_size(std::size_t index)
+    {
+        return min_block << index;
+    }
+
+    // whether ptr lies in one of the pooled regions; caller holds the lock
+    bool in_region(const void* ptr) const
+    {
+        const auto address = reinterpret_cast<std::uintptr_t>(ptr);
+        for (const auto& region : regions)
+        {
+            const auto base = reinterpret_cast<std::uintptr_t>(region.base);
+            if (address >= base && address - base < region.bytes)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // bump allocate a new block from the current region, mapping another region if needed
+    // returns nullptr once max_pooled is reached; caller holds the lock
+    void* carve(std::size_t block)
+    {
+        if (regions.empty() || region_used + block > regions.back().bytes)
+        {
+            if (!add_region(block))
+            {
+                return nullptr;
+            }
+        }
+
+        // all classes are multiples of 16 so every block stays suitably aligned
+        unsigned char* result = static_cast<unsigned char*>(regions.back().base) + region_used;
+        region_used += block;
+        return result;
+    }
+
+    // map the next region: double the last one, but shrink it to what can still be locked
+    // as long as block fits; false when that would pool more than max_pooled; caller holds the lock
+    bool add_region(std::size_t block)
+    {
+        const std::size_t page = page_size();
+        // copies, so std::min does not bind a reference to (odr-use) the C++14 static members
+        const std::size_t first = min_region;
+        const std::size_t largest = max_region;
+        std::size_t bytes = regions.empty() ? first : (std::min)(regions.back().bytes * 2, largest);
+        const std::size_t lockable = (budget > locked_bytes ? budget - locked_bytes : 0) / page * page;
+        if (lockable < bytes && lockable >= block)
+        {
+            bytes = lockable;
+        }
+        bytes = (std::max)(bytes, (block + page - 1) / page * page);
+
+        if (pooled_bytes + bytes > max_pooled)
+        {
+            return false;
+        }
+
+        bool locked = false;
+        void* base = map_locked_region(bytes, locked);
+        if (base == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        if (!locked)
+        {
+            warn_unlocked();
+            ++stats.unlocked_regions;
+        }
+
+        regions.push_back({ base, bytes, locked });
+        pooled_bytes += bytes;
+        locked_bytes += locked ? bytes : 0;
+        region_used = 0;
+        stats.regions = regions.size();
+        return true;
+    }
+
+    void* allocate_large(std::size_t bytes)
+    {
+        const std::size_t page = page_size();
+        const std::size_t rounded = (bytes + page - 1) / page * page;
+
+        bool locked = false;
+        void* region = map_locked_region(rounded, locked);
+        if (region == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (!locked)
+        {
+            warn_unlocked();
+        }
+        ++stats.large_mappings;
+        stats.bytes_in_use += rounded;
+        return region;
+    }
+
+    void deallocate_large(void* ptr, std::size_t bytes) noexcept
+    {
+        const std::size_t page = page_size();
+        const std::size_t rounded = (bytes + page - 1) / page * page;
+
+        unmap_locked_region(ptr, rounded);
+
+        std::lock_guard<std::mutex> guard(lock);
+        --stats.large_mappings;
+        stats.bytes_in_use -= rounded;
+    }
+
+    std::mutex lock;
+    std::array<FreeBlock*, class_count> free_lists{};
+    std::vector<Region> regions;
+    std::size_t region_used = 0;
+    std::size_t pooled_bytes = 0;
+    std::size_t locked_bytes = 0;
+    const std::size_t budget;
+    Stats stats;
+};
+
+/// <summary>
+/// STL allocator adaptor over SecurePool so standard containers can hold secrets, e.g.
+///   std::vector<std::uint8_t, secure_alloc<std::uint8_t>>
+/// </summary>
+/// <typeparam name="T">Element type</typeparam>
+template <typename T>
+struct secure_alloc
+{
+    using value_type = T;
+
+    secure_alloc() noexcept = default;
+
+    template <typename U>
+    secure_alloc(const secure_alloc<U>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        // refuse sizes whose byte count would wrap around
+        if (n > (std::numeric_limits<std::size_t>::max)() / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(SecurePool::instance().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        SecurePool::instance().deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const secure_alloc<T>&, const secure_alloc<U>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const secure_alloc<T>&, const secure_alloc<U>&) noexcept
+{
+    return false;
+}
+
+// containers for key material and plaintext scratch
+// NOTE: secure_string still keeps very short values in its small string buffer, inside the
+//       string object itself, so reserve() past that size before writing secrets into it
+using secure_bytes = std::vector<std::uint8_t, secure_alloc<std::uint8_t>>;
+using secure_string = std::basic_string<char, std::char_traits<char>, secure_alloc<char>>;
+
+/// <summary>
+/// Describes one Base64 variant from RFC 4648. Both variants share A-Z, a-z, 0-9 for values
+/// 0 to 61 and differ only in the last two characters and whether output is padded with '='.
+/// </summary>
+struct Base64Alphabet
+{
+    char c62;
+    char c63;
+    bool pad;
+};
+
+// standard alphabet, padded
+const Base64Alphabet base64_standard{ '+', '/', true };
+
+// URL and filename safe alphabet, unpadded
+const Base64Alphabet base64_url{ '-', '_', false };
+
+// value of a Base64 character or -1 when it is not part of the alphabet
+int base64_value(char c, const Base64Alphabet& alphabet)
+{
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == alphabet.c62) return 62;
+    if (c == alphabet.c63) return 63;
+    return -1;
+}
+
+// character for a 6 bit value
+char base64_char(unsigned value, const Base64Alphabet& alphabet)
+{
+    static const char letters_and_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    if (value == 62) return alphabet.c62;
+    if (value == 63) return alphabet.c63;
+    return letters_and_digits[value];
+}
+
+#ifdef M5_HAVE_SSSE3
+// whether this CPU can run the SSSE3 kernels
+bool cpu_has_ssse3()
+{
+#if !defined(M5_SSSE3_DISPATCH)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+// whether the SSSE3 kernels are used; on when the CPU has them, the self test also turns them off
+bool& ssse3_enabled()
+{
+    static bool enabled = cpu_has_ssse3();
+    return enabled;
+}
+
+// 12 input bytes (in the low 3/4 of the register) to 16 sextets, one per byte
+M5_SSSE3 inline __m128i base64_split_sextets(__m128i in)
+{
+    // [b1 b0 b2 b1] per 32 bit lane so each lane holds one 3 byte group
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+// per class offsets from sextet to character, see base64_sextets_to_ascii
+M5_SSSE3 inline __m128i base64_ascii_offsets(const Base64Alphabet& alphabet)
+{
+    return _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        static_cast<char>(alphabet.c62 - 62), static_cast<char>(alphabet.c63 - 63), 'A', 0, 0);
+}
+
+// 16 sextets to 16 Base64 characters, offsets from base64_ascii_offsets
+M5_SSSE3 inline __m128i base64_sextets_to_ascii(__m128i sextets, __m128i offsets)
+{
+    // reduce each value to a small class index, then add a per class offset
+    //   0..25 -> 13 ('A'), 26..51 -> 0 ('a'), 52..61 -> 1..10 ('0'), 62 -> 11, 63 -> 12
+    __m128i reduced = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+    const __m128i below_26 = _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets);
+    reduced = _mm_or_si128(reduced, _mm_and_si128(below_26, _mm_set1_epi8(13)));
+    return _mm_add_epi8(sextets, _mm_shuffle_epi8(offsets, reduced));
+}
+
+// mask of bytes in [lo, hi]; bytes >= 0x80 compare as negative and never match
+M5_SSSE3 inline __m128i in_range(__m128i in, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(hi + 1)), in));
+}
+
+/// <summary>
+/// SSSE3 bulk of base64_encode_groups: 4 groups per step while 6 or more remain, leaving the
+/// arguments past what was encoded.
+/// </summary>
+M5_SSSE3 void base64_encode_groups_ssse3(const std::uint8_t*& src_io, std::size_t& groups_io, char*& dst_io, const Base64Alphabet alphabet)
+{
+    // the alphabet is a copy and the pointers are locals, so nothing the stores touch can
+    // force the table to be rebuilt per block
+    const std::uint8_t* src = src_io;
+    std::size_t groups = groups_io;
+    char* dst = dst_io;
+    const __m128i offsets = base64_ascii_offsets(alphabet);
+
+    // each step consumes 12 bytes but loads 16, so stop while 4 spare groups remain readable
+    while (groups >= 6)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        const __m128i out = base64_sextets_to_ascii(base64_split_sextets(in), offsets);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+        src += 12;
+        dst += 16;
+        groups -= 4;
+    }
+
+    src_io = src;
+    groups_io = groups;
+    dst_io = dst;
+}
+
+/// <summary>
+/// SSSE3 bulk of base64_decode_quads: 4 quads per step, leaving the arguments past what was decoded.
+/// </summary>
+/// <returns>false when any character is outside the alphabet</returns>
+M5_SSSE3 bool base64_decode_quads_ssse3(const char*& src_io, std::size_t& quads_io, std::uint8_t*& dst_io, const Base64Alphabet alphabet)
+{
+    const char* src = src_io;
+    std::size_t quads = quads_io;
+    std::uint8_t* dst = dst_io;
+
+    // every constant the loop needs, built once
+    const __m128i char62 = _mm_set1_epi8(alphabet.c62);
+    const __m128i char63 = _mm_set1_epi8(alphabet.c63);
+    const __m128i offset_upper = _mm_set1_epi8(-'A');
+    const __m128i offset_lower = _mm_set1_epi8(26 - 'a');
+    const __m128i offset_digit = _mm_set1_epi8(52 - '0');
+    const __m128i offset62 = _mm_set1_epi8(static_cast<char>(62 - alphabet.c62));
+    const __m128i offset63 = _mm_set1_epi8(static_cast<char>(63 - alphabet.c63));
+    const __m128i pair_weights = _mm_set1_epi32(0x01400140);
+    const __m128i lane_weights = _mm_set1_epi32(0x00011000);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    while (quads >= 4)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+        const __m128i upper = in_range(in, 'A', 'Z');
+        const __m128i lower = in_range(in, 'a', 'z');
+        const __m128i digit = in_range(in, '0', '9');
+        const __m128i is62 = _mm_cmpeq_epi8(in, char62);
+        const __m128i is63 = _mm_cmpeq_epi8(in, char63);
+
+        const __m128i valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), digit), _mm_or_si128(is62, is63));
+        if (_mm_movemask_epi8(valid) != 0xffff)
+        {
+            return false;
+        }
+
+        __m128i offset = _mm_and_si128(upper, offset_upper);
+        offset = _mm_or_si128(offset, _mm_and_si128(lower, offset_lower));
+        offset = _mm_or_si128(offset, _mm_and_si128(digit, offset_digit));
+        offset = _mm_or_si128(offset, _mm_and_si128(is62, offset62));
+        offset = _mm_or_si128(offset, _mm_and_si128(is63, offset63));
+        const __m128i sextets = _mm_add_epi8(in, offset);
+
+        // pack pairs of sextets to 12 bits, then pairs of those to 24 bits per lane
+        const __m128i pairs = _mm_maddubs_epi16(sextets, pair_weights);
+        const __m128i lanes = _mm_madd_epi16(pairs, lane_weights);
+        const __m128i packed = _mm_shuffle_epi8(lanes, pack);
+
+        // only 12 of the 16 bytes are output
+        alignas(16) std::uint8_t block[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(block), packed);
+        std::memcpy(dst, block, 12);
+
+        src += 16;
+        dst += 12;
+        quads -= 4;
+    }
+
+    src_io = src;
+    quads_io = quads;
+    dst_io = dst;
+    return true;
+}
+#endif
+
+/// <summary>
+/// Encode whole 3 byte groups. Partial groups and padding are handled by the caller.
+/// </summary>
+/// <param name="src">groups * 3 input bytes</param>
+/// <param name="groups">Number of 3 byte groups</param>
+/// <param name="dst">Room for groups * 4 characters</param>
+void base64_encode_groups(const std::uint8_t* src, std::size_t groups, char* dst, const Base64Alphabet& alphabet_in)
+{
+    // dst is char*, so every store may alias the caller's alphabet; a local copy keeps it
+    // in registers instead of reloading it per group
+    const Base64Alphabet alphabet = alphabet_in;
+#ifdef M5_HAVE_SSSE3
+    if (groups >= 6 && ssse3_enabled())
+    {
+        base64_encode_groups_ssse3(src, groups, dst, alphabet);
+    }
+#endif
+    for (; groups > 0; --groups)
+    {
+        const std::uint32_t bits = (std::uint32_t(src[0]) << 16) | (std::uint32_t(src[1]) << 8) | src[2];
+        dst[0] = base64_char((bits >> 18) & 0x3f, alphabet);
+        dst[1] = base64_char((bits >> 12) & 0x3f, alphabet);
+        dst[2] = base64_char((bits >> 6) & 0x3f, alphabet);
+        dst[3] = base64_char(bits & 0x3f, alphabet);
+        src += 3;
+        dst += 4;
+    }
+}
+
+/// <summary>
+/// Decode whole 4 character quads with no padding.
+/// </summary>
+/// <param name="src">quads * 4 characters</param>
+/// <param name="quads">Number of quads</param>
+/// <param name="dst">Room for quads * 3 bytes</param>
+/// <returns>false when any character is outside the alphabet</returns>
+bool base64_decode_quads(const char* src, std::size_t quads, std::uint8_t* dst, const Base64Alphabet& alphabet_in)
+{
+    // local copy for the same aliasing reason as base64_encode_groups (dst is uint8_t*)
+    const Base64Alphabet alphabet = alphabet_in;
+#ifdef M5_HAVE_SSSE3
+    if (quads >= 4 && ssse3_enabled() && !base64_decode_quads_ssse3(src, quads, dst, alphabet))
+    {
+        return false;
+    }
+#endif
+    for (; quads > 0; --quads)
+    {
+        const int a = base64_value(src[0], alphabet);
+        const int b = base64_value(src[1], alphabet);
+        const int c = base64_value(src[2], alphabet);
+        const int d = base64_value(src[3], alphabet);
+        if ((a | b | c | d) < 0)
+        {
+            return false;
+        }
+
+        const std::uint32_t bits = (std::uint32_t(a) << 18) | (std::uint32_t(b) << 12) | (std::uint32_t(c) << 6) | std::uint32_t(d);
+        dst[0] = static_cast<std::uint8_t>(bits >> 16);
+        dst[1] = static_cast<std::uint8_t>(bits >> 8);
+        dst[2] = static_cast<std::uint8_t>(bits);
+        src += 4;
+        dst += 3;
+    }
+    return true;
+}
+
+/// <summary>
+/// Chunked Base64 encoder. Feed any number of update() calls, then finish() once to flush the
+/// last partial group. The encoder can be reused after finish().
+/// </summary>
+class Base64Encoder
+{
+public:
+    explicit Base64Encoder(const Base64Alphabet& alphabet = base64_standard) : alphabet(alphabet) {}
+
+    // append the encoding of data to out
+    void update(const std::uint8_t* data, std::size_t bytes, std::string& out)
+    {
+        // top up a group left over from the previous chunk
+        while (carried > 0 && carried < 3 && bytes > 0)
+        {
+            carry[carried++] = *data++;
+            --bytes;
+        }
+        if (carried == 3)
+        {
+            append_groups(carry, 1, out);
+            carried = 0;
+        }
+
+        const std::size_t groups = bytes / 3;
+        append_groups(data, groups, out);
+        data += groups * 3;
+        bytes -= groups * 3;
+
+        // keep the remainder for the next chunk
+        while (bytes > 0)
+        {
+            carry[carried++] = *data++;
+            --bytes;
+        }
+    }
+
+    // flush the last 1 or 2 bytes, padding if the alphabet requires it
+    void finish(std::string& out)
+    {
+        if (carried > 0)
+        {
+            const std::uint32_t bits = (std::uint32_t(carry[0]) << 16) | (carried > 1 ? std::uint32_t(carry[1]) << 8 : 0);
+            out.push_back(base64_char((bits >> 18) & 0x3f, alphabet));
+            out.push_back(base64_char((bits >> 12) & 0x3f, alphabet));
+            if (carried > 1)
+            {
+                out.push_back(base64_char((bits >> 6) & 0x3f, alphabet));
+            }
+            if (alphabet.pad)
+            {
+                out.append(carried == 1 ? "==" : "=");
+            }
+        }
+        carried = 0;
+    }
+
+private:
+    void append_groups(const std::uint8_t* src, std::size_t groups, std::string& out)
+    {
+        if (groups == 0)
+        {
+            return;
+        }
+        const std::size_t offset = out.size();
+        out.resize(offset + groups * 4);
+        base64_encode_groups(src, groups, &out[offset], alphabet);
+    }
+
+    Base64Alphabet alphabet;
+    std::uint8_t carry[3]{};
+    std::size_t carried = 0;
+};
+
+/// <summary>
+/// Chunked strict Base64 decoder. Rejects characters outside the alphabet (including whitespace),
+/// padding anywhere but the end, a missing or unexpected padding for the alphabet, truncated input
+/// and non-zero unused bits in the last quad, so every byte string has exactly one accepted encoding.
+/// </summary>
+class Base64Decoder
+{
+public:
+    explicit Base64Decoder(const Base64Alphabet& alphabet = base64_standard) : alphabet(alphabet) {}
+
+    /// <summary>
+    /// Append the decoding of the next chunk of text to out.
+    /// </summary>
+    /// <exception cref="std::invalid_argument">The input is not valid Base64</exception>
+    void update(const char* text, std::size_t length, std::vector<std::uint8_t>& out)
+    {
+        if (length == 0)
+        {
+            return;
+        }
+        if (padded)
+        {
+            throw std::invalid_argument("Base64: data after padding");
+        }
+
+        // top up a quad left over from the previous chunk
+        while (carried > 0 && carried < 4 && length > 0)
+        {
+            carry[carried++] = *text++;
+            --length;
+        }
+        if (carried == 4)
+        {
+            carried = 0;
+            decode_final_quad(carry, out, length == 0);
+        }
+
+        std::size_t quads = length / 4;
+        if (quads > 0)
+        {
+            // padding can only appear in the last quad of the input, keep it off the fast path
+            const bool last_padded = alphabet.pad && text[quads * 4 - 1] == '=';
+            const std::size_t bulk = last_padded ? quads - 1 : quads;
+
+            const std::size_t offset = out.size();
+            out.resize(offset + bulk * 3);
+            if (!base64_decode_quads(text, bulk, out.data() + offset, alphabet))
+            {
+                throw std::invalid_argument("Base64: invalid character");
+            }
+            text += bulk * 4;
+            length -= quads * 4;
+
+            if (last_padded)
+            {
+                decode_final_quad(text, out, length == 0);
+                text += 4;
+            }
+        }
+
+        // keep the remainder for the next chunk
+        while (length > 0)
+        {
+            carry[carried++] = *text++;
+            --length;
+        }
+    }
+
+    /// <summary>
+    /// Check the input ended on a valid boundary and flush an unpadded final quad.
+    /// </summary>
+    /// <exception cref="std::invalid_argument">The input was truncated</exception>
+    void finish(std::vector<std::uint8_t>& out)
+    {
+        const std::size_t left = carried;
+        carried = 0;
+        padded = false;
+
+        if (left == 0)
+        {
+            return;
+        }
+        if (alphabet.pad || left == 1)
+        {
+            throw std::invalid_argument("Base64: truncated input");
+        }
+        decode_partial(carry, left, out);
+    }
+
+private:
+    // decode one quad that may hold padding; nothing may follow a padded quad
+    void decode_final_quad(const char* quad, std::vector<std::uint8_t>& out, bool at_end)
+    {
+        if (!alphabet.pad || quad[3] != '=')
+        {
+            const std::size_t offset = out.size();
+            out.resize(offset + 3);
+            if (!base64_decode_quads(quad, 1, out.data() + offset, alphabet))
+            {
+                throw std::invalid_argument("Base64: invalid character");
+            }
+            return;
+        }
+
+        if (!at_end)
+        {
+            throw std::invalid_argument("Base64: data after padding");
+        }
+        padded = true;
+        decode_partial(quad, quad[2] == '=' ? 2 : 3, out);
+    }
+
+    // decode 2 or 3 significant characters to 1 or 2 bytes
+    void decode_partial(const char* quad, std::size_t significant, std::vector<std::uint8_t>& out)
+    {
+        const int a = base64_value(quad[0], alphabet);
+        const int b = base64_value(quad[1], alphabet);
+        const int c = significant > 2 ? base64_value(quad[2], alphabet) : 0;
+        if ((a | b | c) < 0)
+        {
+            throw std::invalid_argument("Base64: invalid character");
+        }
+
+        const std::uint32_t bits = (std::uint32_t(a) << 18) | (std::uint32_t(b) << 12) | (std::uint32_t(c) << 6);
+
+        // bits past the last whole byte must be zero
+        const std::uint32_t unused = significant == 2 ? 0x00ffff : 0x0000ff;
+        if ((bits & unused) != 0)
+        {
+            throw std::invalid_argument("Base64: non-canonical encoding");
+        }
+
+        out.push_back(static_cast<std::uint8_t>(bits >> 16));
+        if (significant > 2)
+        {
+            out.push_back(static_cast<std::uint8_t>(bits >> 8));
+        }
+    }
+
+    Base64Alphabet alphabet;
+    char carry[4]{};
+    std::size_t carried = 0;
+    bool padded = false;
+};
+
+/// <summary>
+/// One shot Base64 encode.
+/// </summary>
+std::string base64_encode(const std::uint8_t* data, std::size_t bytes, const Base64Alphabet& alphabet = base64_standard)
+{
+    HOT_PATH_TIMER("base64_encode");
+
+    std::string out;
+    out.reserve((bytes + 2) / 3 * 4);
+    Base64Encoder encoder(alphabet);
+    encoder.update(data, bytes, out);
+    encoder.finish(out);
+    return out;
+}
+
+/// <summary>
+/// One shot strict Base64 decode.
+/// </summary>
+/// <exception cref="std::invalid_argument">The input is not valid Base64</exception>
+std::vector<std::uint8_t> base64_decode(const std::string& text, const Base64Alphabet& alphabet = base64_standard)
+{
+    HOT_PATH_TIMER("base64_decode");
+
+    std::vector<std::uint8_t> out;
+    out.reserve(text.size() / 4 * 3 + 2);
+    Base64Decoder decoder(alphabet);
+    decoder.update(text.data(), text.size(), out);
+    decoder.finish(out);
+    return out;
+}
+
+#ifdef M5_HAVE_SSSE3
+/// <summary>
+/// SSSE3 bulk of hex_encode: 16 bytes per step, leaving the arguments past what was encoded.
+/// </summary>
+M5_SSSE3 void hex_encode_ssse3(const std::uint8_t*& data_io, std::size_t& bytes_io, char*& dst_io)
+{
+    const std::uint8_t* data = data_io;
+    std::size_t bytes = bytes_io;
+    char* dst = dst_io;
+
+    const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    while (bytes >= 16)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(in, 4), low_nibble));
+        const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(in, low_nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi8(hi, lo));
+        data += 16;
+        dst += 32;
+        bytes -= 16;
+    }
+
+    data_io = data;
+    bytes_io = bytes;
+    dst_io = dst;
+}
+#endif
+
+/// <summary>
+/// Append the lowercase hex encoding of data to out. Hex has no state across chunks,
+/// so calling this once per chunk is already streaming.
+/// </summary>
+void hex_encode(const std::uint8_t* data, std::size_t bytes, std::string& out)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    const std::size_t offset = out.size();
+    out.resize(offset + bytes * 2);
+    char* dst = &out[offset];
+
+#ifdef M5_HAVE_SSSE3
+    if (bytes >= 16 && ssse3_enabled())
+    {
+        hex_encode_ssse3(data, bytes, dst);
+    }
+#endif
+    for (; bytes > 0; --bytes)
+    {
+        *dst++ = digits[*data >> 4];
+        *dst++ = digits[*data & 0x0f];
+        ++data;
+    }
+}
+
+/// <summary>
+/// One shot hex encode.
+/// </summary>
+std::string hex_encode(const std::uint8_t* data, std::size_t bytes)
+{
+    HOT_PATH_TIMER("hex_encode");
+
+    std::string out;
+    hex_encode(data, bytes, out);
+    return out;
+}
+
+// value of a hex digit (either case) or -1
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+#ifdef M5_HAVE_SSSE3
+// 16 hex characters to their nibble values; valid is cleared when any character is not a hex digit
+M5_SSSE3 inline __m128i hex_nibbles(__m128i in, bool& valid)
+{
+    const __m128i digit = in_range(in, '0', '9');
+    const __m128i lower = in_range(in, 'a', 'f');
+    const __m128i upper = in_range(in, 'A', 'F');
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(digit, lower), upper)) != 0xffff)
+    {
+        valid = false;
+    }
+
+    __m128i offset = _mm_and_si128(digit, _mm_set1_epi8(-'0'));
+    offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(10 - 'a')));
+    offset = _mm_or_si128(offset, _mm_and_si128(upper, _mm_set1_epi8(10 - 'A')));
+    return _mm_add_epi8(in, offset);
+}
+
+/// <summary>
+/// SSSE3 bulk of HexDecoder::update: 16 pairs per step, leaving the arguments past what was decoded.
+/// </summary>
+/// <returns>false when any character is not a hex digit</returns>
+M5_SSSE3 bool hex_decode_pairs_ssse3(const char*& text_io, std::size_t& pairs_io, std::uint8_t*& dst_io)
+{
+    const char* text = text_io;
+    std::size_t pairs = pairs_io;
+    std::uint8_t* dst = dst_io;
+
+    // (hi, lo) pairs to hi * 16 + lo
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    bool valid = true;
+    while (pairs >= 16)
+    {
+        const __m128i a = hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text)), valid);
+        const __m128i b = hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + 16)), valid);
+
+        // then narrow to bytes
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights)));
+
+        text += 32;
+        dst += 16;
+        pairs -= 16;
+    }
+
+    text_io = text;
+    pairs_io = pairs;
+    dst_io = dst;
+    return valid;
+}
+#endif
+
+/// <summary>
+/// Chunked strict hex decoder. Accepts either case, rejects anything else, including an odd
+/// number of digits at finish().
+/// </summary>
+class HexDecoder
+{
+public:
+    /// <exception cref="std::invalid_argument">The input holds a non hex character</exception>
+    void update(const char* text, std::size_t length, std::vector<std::uint8_t>& out)
+    {
+        // pair a digit left over from the previous chunk
+        if (carried && length > 0)
+        {
+            const int hi = hex_value(carry);
+            const int lo = hex_value(*text);
+            if ((hi | lo) < 0)
+            {
+                throw std::invalid_argument("hex: invalid character");
+            }
+            out.push_back(static_cast<std::uint8_t>((hi << 4) | lo));
+            carried = false;
+            ++text;
+            --length;
+        }
+
+        const std::size_t pairs = length / 2;
+        const std::size_t offset = out.size();
+        out.resize(offset + pairs);
+        std::uint8_t* dst = out.data() + offset;
+        std::size_t left = pairs;
+
+#ifdef M5_HAVE_SSSE3
+        if (left >= 16 && ssse3_enabled() && !hex_decode_pairs_ssse3(text, left, dst))
+        {
+            throw std::invalid_argument("hex: invalid character");
+        }
+#endif
+        for (; left > 0; --left)
+        {
+            const int hi = hex_value(text[0]);
+            const int lo = hex_value(text[1]);
+            if ((hi | lo) < 0)
+            {
+                throw std::invalid_argument("hex: invalid character");
+            }
+            *dst++ = static_cast<std::uint8_t>((hi << 4) | lo);
+            text += 2;
+        }
+
+        if (length % 2 != 0)
+        {
+            carry = *text;
+            carried = true;
+        }
+    }
+
+    /// <exception cref="std::invalid_argument">The input had an odd number of digits</exception>
+    void finish()
+    {
+        const bool odd = carried;
+        carried = false;
+        if (odd)
+        {
+            throw std::invalid_argument("hex: odd number of digits");
+        }
+    }
+
+private:
+    char carry = 0;
+    bool carried = false;
+};
+
+/// <summary>
+/// One shot strict hex decode.
+/// </summary>
+/// <exception cref="std::invalid_argument">The input is not valid hex</exception>
+std::vector<std::uint8_t> hex_decode(const std::string& text)
+{
+    HOT_PATH_TIMER("hex_decode");
+
+    std::vector<std::uint8_t> out;
+    out.reserve(text.size() / 2);
+    HexDecoder decoder;
+    decoder.update(text.data(), text.size(), out);
+    decoder.finish();
+    return out;
+}
+
+/// <summary>
+/// Compare the pool against locking every allocation on its own (new + mlock + zero + munlock + delete).
+/// </summary>
+void do_secure_alloc_benchmark()
+{
+    const std::size_t iterations = 200000;
+    const std::array<std::size_t, 5> sizes{ 32, 256, 1024, 4096, 16384 };
+
+    std::cout << "Secure allocation benchmark (" << iterations << " iterations per size)" << std::endl;
+
+    for (auto size : sizes)
+    {
+        // pooled: locked once up front, zeroed on every free
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            void* block = SecurePool::instance().allocate(size);
+            static_cast<volatile unsigned char*>(block)[0] = static_cast<unsigned char>(i);
+            SecurePool::instance().deallocate(block, size);
+        }
+        auto pooled = std::chrono::steady_clock::now() - start;
+
+        // baseline: a lock and unlock system call around every allocation
+        bool baseline_done = true;
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            unsigned char* block = new unsigned char[size];
+            if (!lock_pages(block, size))
+            {
+                delete[] block;
+                baseline_done = false;
+                break;
+            }
+            static_cast<volatile unsigned char*>(block)[0] = static_cast<unsigned char>(i);
+            secure_zero(block, size);
+            unlock_pages(block, size);
+            delete[] block;
+        }
+        auto baseline = std::chrono::steady_clock::now() - start;
+
+        const auto pooled_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(pooled).count() / static_cast<double>(iterations);
+        const auto baseline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(baseline).count() / static_cast<double>(iterations);
+
+        std::cout << "\t" << size << " bytes: pool " << pooled_ns << " ns/op";
+        if (baseline_done)
+        {
+            std::cout << ", new + mlock " << baseline_ns << " ns/op" << std::endl;
+        }
+        else
+        {
+            // a partial run divided by every iteration would understate the cost
+            std::cout << ", new + mlock skipped (mlock failed)" << std::endl;
+        }
+    }
+}
+
+// which kernels the codecs are running, for the benchmark and self test output
+const char* kernel_name()
+{
+#ifdef M5_HAVE_SSSE3
+    return ssse3_enabled() ? "SSSE3" : "scalar";
+#else
+    return "scalar";
+#endif
+}
+
+/// <summary>
+/// Throughput of Base64 and hex encode / decode from 1 KB up to max_bytes (1 GB by default).
+/// Small sizes are repeated so each measurement covers at least 256 MB of input.
+/// </summary>
+/// <param name="max_bytes">Largest input size to try</param>
+void do_encoding_benchmark(std::size_t max_bytes)
+{
+    const std::size_t min_total = std::size_t(256) * 1024 * 1024;
+
+    std::cout << "Encoding benchmark (" << kernel_name() << " kernels)" << std::endl;
+
+    for (std::size_t size = 1024; size <= max_bytes; size *= 32)
+    {
+        try
+        {
+            std::vector<std::uint8_t> data(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                data[i] = static_cast<std::uint8_t>(i * 2654435761u >> 13);
+            }
+
+            const std::size_t repeat = size >= min_total ? 1 : min_total / size;
+
+            // MB/s of raw (unencoded) bytes for one timed operation repeated `repeat` times
+            auto rate = [&](std::chrono::steady_clock::duration elapsed)
+            {
+                const double seconds = std::chrono::duration<double>(elapsed).count();
+                return static_cast<double>(size) * repeat / seconds / (1024.0 * 1024.0);
+            };
+
+            std::string text;
+            std::vector<std::uint8_t> decoded;
+
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t r = 0; r < repeat; ++r)
+            {
+                text = base64_encode(data.data(), data.size());
+            }
+            const double b64_encode = rate(std::chrono::steady_clock::now() - start);
+
+            start = std::chrono::steady_clock::now();
+            for (std::size_t r = 0; r < repeat; ++r)
+            {
+                decoded = base64_decode(text);
+            }
+            const double b64_decode = rate(std::chrono::steady_clock::now() - start);
+
+            start = std::chrono::steady_clock::now();
+            for (std::size_t r = 0; r < repeat; ++r)
+            {
+                text = hex_encode(data.data(), data.size());
+            }
+            const double hex_enc = rate(std::chrono::steady_clock::now() - start);
+
+            start = std::chrono::steady_clock::now();
+            for (std::size_t r = 0; r < repeat; ++r)
+            {
+                decoded = hex_decode(text);
+            }
+            const double hex_dec = rate(std::chrono::steady_clock::now() - start);
+
+            std::cout << "\t" << size << " bytes: base64 encode " << b64_encode << " MB/s, decode " << b64_decode
+                      << " MB/s, hex encode " << hex_enc << " MB/s, decode " << hex_dec << " MB/s" << std::endl;
+        }
+        catch (std::bad_alloc&)
+        {
+            std::cout << "\t" << size << " bytes: not enough memory, skipped" << std::endl;
+        }
+    }
+}
+
+// straightforward bit at a time Base64, the reference the self test checks the codecs against
+std::string reference_base64(const std::vector<std::uint8_t>& data, const Base64Alphabet& alphabet)
+{
+    const std::string table = std::string("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789") + alphabet.c62 + alphabet.c63;
+
+    std::string out;
+    std::uint32_t buffer = 0;
+    int bits = 0;
+    for (std::uint8_t byte : data)
+    {
+        buffer = (buffer << 8) | byte;
+        bits += 8;
+        while (bits >= 6)
+        {
+            bits -= 6;
+            out.push_back(table[(buffer >> bits) & 0x3f]);
+        }
+    }
+    if (bits > 0)
+    {
+        out.push_back(table[(buffer << (6 - bits)) & 0x3f]);
+    }
+    while (alphabet.pad && out.size() % 4 != 0)
+    {
+        out.push_back('=');
+    }
+    return out;
+}
+
+// reference lowercase hex
+std::string reference_hex(const std::vector<std::uint8_t>& data)
+{
+    std::string out;
+    for (std::uint8_t byte : data)
+    {
+        out.push_back("0123456789abcdef"[byte >> 4]);
+        out.push_back("0123456789abcdef"[byte & 0x0f]);
+    }
+    return out;
+}
+
+/// <summary>
+/// Checks of the Base64 and hex codecs, run by --selftest with whichever kernels are enabled.
+/// Lengths cover both sides of the SIMD block sizes (18 input bytes per encode step, 16 characters
+/// per decode step, 16 bytes per hex step), the streaming classes get random chunk splits, and
+/// malformed input must be rejected wherever in the text the fault is.
+/// </summary>
+class CodecSelfTest
+{
+public:
+    // run every check, returning the number that failed
+    std::size_t run()
+    {
+        for (std::size_t length = 0; length <= 100; ++length)
+        {
+            check_length(length);
+        }
+        for (std::size_t length : { 255, 256, 257, 1000, 4099 })
+        {
+            check_length(length);
+        }
+
+        check_rejections();
+        return failures;
+    }
+
+    std::size_t checks = 0;
+    std::size_t failures = 0;
+
+private:
+    void expect(bool passed, const std::string& what)
+    {
+        ++checks;
+        if (!passed)
+        {
+            ++failures;
+            std::cout << "\tFAILED: " << what << std::endl;
+        }
+    }
+
+    // decode must throw std::invalid_argument
+    template <typename Decode>
+    void expect_rejected(Decode decode, const std::string& what)
+    {
+        bool rejected = false;
+        try
+        {
+            decode();
+        }
+        catch (std::invalid_argument&)
+        {
+            rejected = true;
+        }
+        expect(rejected, what + " is rejected");
+    }
+
+    // random split points for the streaming checks, including empty chunks
+    std::vector<std::size_t> chunks(std::size_t length)
+    {
+        std::vector<std::size_t> sizes;
+        std::uniform_int_distribution<std::size_t> size(0, 40);
+        for (std::size_t done = 0; done < length;)
+        {
+            const std::size_t next = (std::min)(size(random), length - done);
+            sizes.push_back(next);
+            done += next;
+        }
+        return sizes;
+    }
+
+    std::vector<std::uint8_t> random_bytes(std::size_t length)
+    {
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::vector<std::uint8_t> data(length);
+        for (auto& value : data)
+        {
+            value = static_cast<std::uint8_t>(byte(random));
+        }
+        return data;
+    }
+
+    void check_length(std::size_t length)
+    {
+        const std::vector<std::uint8_t> data = random_bytes(length);
+        const std::string size = std::to_string(length) + " bytes";
+
+        for (const Base64Alphabet* alphabet : { &base64_standard, &base64_url })
+        {
+            const std::string name = (alphabet->pad ? "base64 " : "base64url ") + size;
+            const std::string expected = reference_base64(data, *alphabet);
+
+            expect(base64_encode(data.data(), data.size(), *alphabet) == expected, name + " encode");
+            try
+            {
+                expect(base64_decode(expected, *alphabet) == data, name + " decode");
+            }
+            catch (std::invalid_argument& x)
+            {
+                expect(false, name + " decode threw " + x.what());
+            }
+
+            // the same through the streaming classes, in random chunks
+            std::string text;
+            Base64Encoder encoder(*alphabet);
+            std::size_t done = 0;
+            for (std::size_t chunk : chunks(data.size()))
+            {
+                encoder.update(data.data() + done, chunk, text);
+                done += chunk;
+            }
+            encoder.finish(text);
+            expect(text == expected, name + " chunked encode");
+
+            std::vector<std::uint8_t> decoded;
+            try
+            {
+                Base64Decoder decoder(*alphabet);
+                done = 0;
+                for (std::size_t chunk : chunks(expected.size()))
+                {
+                    decoder.update(expected.data() + done, chunk, decoded);
+                    done += chunk;
+                }
+                decoder.finish(decoded);
+                expect(decoded == data, name + " chunked decode");
+            }
+            catch (std::invalid_argument& x)
+            {
+                expect(false, name + " chunked decode threw " + x.what());
+            }
+        }
+
+        const std::string hex = reference_hex(data);
+        expect(hex_encode(data.data(), data.size()) == hex, "hex " + size + " encode");
+
+        std::string upper = hex;
+        for (auto& c : upper)
+        {
+            c = (c >= 'a' && c <= 'f') ? static_cast<char>(c - 'a' + 'A') : c;
+        }
+        try
+        {
+            expect(hex_decode(hex) == data, "hex " + size + " decode");
+            expect(hex_decode(upper) == data, "hex " + size + " uppercase decode");
+
+            std::vector<std::uint8_t> decoded;
+            HexDecoder decoder;
+            std::size_t done = 0;
+            for (std::size_t chunk : chunks(hex.size()))
+            {
+                decoder.update(hex.data() + done, chunk, decoded);
+                done += chunk;
+            }
+            decoder.finish();
+            expect(decoded == data, "hex " + size + " chunked decode");
+        }
+        catch (std::invalid_argument& x)
+        {
+            expect(false, "hex " + size + " decode threw " + std::string(x.what()));
+        }
+    }
+
+    void check_rejections()
+    {
+        // short inputs, handled by the scalar code whatever the kernels
+        const char* const bad_standard[] = {
+            "Zm9v=mFy",     // padding inside the data
+            "Zg==Zm9v",     // data after padding
+            "=Zm9",         // padding first
+            "Zg=a",         // padding followed by a character
+            "Zg",           // missing padding
+            "Zm8",          // missing padding
+            "Zh==",         // non-zero trailing bits
+            "Zm9=",         // non-zero trailing bits
+            "Zm9v YmFy",    // whitespace
+            "Zm9v\nYmFy",   // line break
+            "Zm9v\xc3\xa9", // bytes >= 0x80
+            "Zm9vY",        // truncated
+            "Zm-_",         // URL safe characters
+        };
+        for (const char* text : bad_standard)
+        {
+            expect_rejected([text] { base64_decode(text); }, "base64 \"" + std::string(text) + "\"");
+        }
+
+        const char* const bad_url[] = { "Zg==", "Zh", "Zm9", "Zm+/", "Zm9vY", "Zm9v\x80" };
+        for (const char* text : bad_url)
+        {
+            expect_rejected([text] { base64_decode(text, base64_url); }, "base64url \"" + std::string(text) + "\"");
+        }
+
+        const char* const bad_hex[] = { "abc", "zz", "0g", "a b", "\xff\xff", "0x00" };
+        for (const char* text : bad_hex)
+        {
+            expect_rejected([text] { hex_decode(text); }, "hex \"" + std::string(text) + "\"");
+        }
+
+        // one bad character at every position of inputs long enough for the SIMD paths
+        const std::vector<std::uint8_t> data = random_bytes(75);
+        const std::string base64 = reference_base64(data, base64_standard);
+        const std::string hex = reference_hex(data);
+        const char bad[] = { ' ', '\n', '*', '\x80', '\xff' };
+        for (std::size_t at = 0; at < base64.size(); ++at)
+        {
+            for (char c : bad)
+            {
+                std::string text = base64;
+                text[at] = c;
+                expect_rejected([&text] { base64_decode(text); }, "base64 with byte " + std::to_string(static_cast<unsigned char>(c)) + " at " + std::to_string(at));
+            }
+
+            // '=' anywhere but the last quad
+            if (at + 4 < base64.size())
+            {
+                std::string text = base64;
+                text[at] = '=';
+                expect_rejected([&text] { base64_decode(text); }, "base64 with = at " + std::to_string(at));
+            }
+        }
+        for (std::size_t at = 0; at < hex.size(); ++at)
+        {
+            for (char c : { 'g', ' ', '\x80' })
+            {
+                std::string text = hex;
+                text[at] = c;
+                expect_rejected([&text] { hex_decode(text); }, "hex with byte " + std::to_string(static_cast<unsigned char>(c)) + " at " + std::to_string(at));
+            }
+        }
+        expect_rejected([&hex] { hex_decode(hex.substr(1)); }, "hex with an odd number of digits");
+    }
+
+    // fixed seed, so a failure replays
+    std::mt19937 random{ 20240601 };
+};
+
+/// <summary>
+/// Run the codec self test with each available set of kernels.
+/// </summary>
+/// <returns>true when every check passed</returns>
+bool do_selftest()
 {
-    std::cout << "Hello World!\n";
+    std::vector<bool> kernels{ false };
+#ifdef M5_HAVE_SSSE3
+    const bool original = ssse3_enabled();
+    if (cpu_has_ssse3())
+    {
+        kernels.push_back(true);
+    }
+#endif
+
+    std::size_t failures = 0;
+    for (bool simd : kernels)
+    {
+#ifdef M5_HAVE_SSSE3
+        ssse3_enabled() = simd;
+#endif
+        CodecSelfTest test;
+        test.run();
+        std::cout << "Self test (" << (simd ? "SSSE3" : "scalar") << " kernels): " << test.checks << " checks, "
+                  << test.failures << " failed" << std::endl;
+        failures += test.failures;
+    }
+
+#ifdef M5_HAVE_SSSE3
+    ssse3_enabled() = original;
+#endif
+    return failures == 0;
+}
+
+/// <summary>
+/// Entry point into the application
+/// </summary>
+/// <returns>0 when complete, 1 when --selftest fails</returns>
+int main(int argc, char* argv[])
+{
+    // hot path latency tables on std::cerr when built with HOT_PATH_TIMING
+    HOT_PATH_DUMP_EVERY(1000);
+
+    // pass --bench [max encoding bytes] to run the benchmarks instead of the demo
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+    {
+        const std::size_t max_bytes = argc > 2 ? std::stoull(argv[2]) : std::size_t(1) << 30;
+        try
+        {
+            do_secure_alloc_benchmark();
+        }
+        catch (std::bad_alloc&)
+        {
+            std::cout << "Secure memory unavailable, allocation benchmark skipped" << std::endl;
+        }
+        do_encoding_benchmark(max_bytes);
+        return 0;
+    }
+
+    // pass --selftest to check the encoders and decoders against a reference implementation
+    if (argc > 1 && std::string(argv[1]) == "--selftest")
+    {
+        return do_selftest() ? 0 : 1;
+    }
+
+    std::cout << "Encryption Tests!" << std::endl;
+
+    try
+    {
+        // key material lives in locked memory and is zeroed when the vector releases it
+        secure_bytes key(32);
+        for (std::size_t i = 0; i < key.size(); ++i)
+        {
+            key[i] = static_cast<std::uint8_t>(i);
+        }
+
+        const auto stats = SecurePool::instance().usage();
+        std::cout << "Key of " << key.size() << " bytes held in " << stats.regions << " region(s) ("
+                  << stats.unlocked_regions << " not locked), " << stats.bytes_in_use << " secure bytes in use" << std::endl;
+    }
+    catch (std::bad_alloc&)
+    {
+        std::cout << "Secure memory unavailable, key demo skipped" << std::endl;
+    }
+
+    std::cout << "Secure bytes in use after release: " << SecurePool::instance().usage().bytes_in_use << std::endl;
+
+    // text safe forms of (stand in) ciphertext for config files and logs
+    const std::vector<std::uint8_t> ciphertext{ 0xfb, 0xff, 0x00, 0x10, 0x83, 0x3e, 0x7f };
+    const std::string standard = base64_encode(ciphertext.data(), ciphertext.size());
+    const std::string url_safe = base64_encode(ciphertext.data(), ciphertext.size(), base64_url);
+    const std::string hex = hex_encode(ciphertext.data(), ciphertext.size());
+
+    std::cout << "Base64: " << standard << "  URL safe: " << url_safe << "  hex: " << hex << std::endl;
+    std::cout << "Round trips: " << std::boolalpha
+              << (base64_decode(standard) == ciphertext) << " "
+              << (base64_decode(url_safe, base64_url) == ciphertext) << " "
+              << (hex_decode(hex) == ciphertext) << std::endl;
+
+    // malformed input is rejected, not skipped over
+    try
+    {
+        base64_decode("Zm9v YmFy");
+    }
+    catch (std::invalid_argument& x)
+    {
+        std::cout << "Rejected: " << x.what() << std::endl;
+    }
+
+    return 0;
 }
 
 // Run program: Ctrl + F5 or Debug > Start Without Debugging menu
 // Debug program: F5 or Debug > Start Debugging menu
-
-// Tips for Getting Started: 
-//   1. Use the Solution Explorer window to add/manage files
-//   2. Use the Team Explorer window to connect to source control
-//   3. Use the Output window to see build output and other messages
-//   4. Use the Error List window to view errors
-//   5. Go to Project > Add New Item to create new code files, or Project > Add Existing Item to add existing code files to the project
-//   6. In the future, to open this project again, go to File > Open > Project and select the .sln file